@@ -0,0 +1,465 @@
+/**
+ * Copyright 2021 Christoph Groß
+ *
+ * This file is part of Glance.
+ *
+ * Glance is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Glance is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Glance.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <cmath>
+#include <cstddef>
+#include <iostream>
+#include <vector>
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include "glance.hpp"
+
+/**
+ * @brief   A vertex of the example scene
+ */
+struct Vertex
+{
+    float mPosition[3];
+    float mColor[3];
+};
+
+/**
+ * @brief   Multiply two 4x4 matrices
+ * @param   aLeft [in] Left matrix, 16 floats in column-major order
+ * @param   aRight [in] Right matrix, 16 floats in column-major order
+ * @param   aResult [out] Product aLeft * aRight
+ */
+void multiply(const float *aLeft, const float *aRight, float *aResult);
+
+/**
+ * @brief   Build a perspective projection matrix, see gluPerspective
+ * @param   aFovY [in] Vertical field of view in radians
+ * @param   aAspect [in] Width divided by height of the viewport
+ * @param   aNear [in] Distance of the near plane
+ * @param   aFar [in] Distance of the far plane
+ * @param   aResult [out] Matrix, 16 floats in column-major order
+ */
+void perspective(float aFovY, float aAspect, float aNear, float aFar,
+                 float *aResult);
+
+/**
+ * @brief   Build a view matrix, see gluLookAt
+ * @param   aEye [in] Position of the camera
+ * @param   aCenter [in] Point the camera looks at
+ * @param   aResult [out] Matrix, 16 floats in column-major order
+ */
+void lookAt(const float *aEye, const float *aCenter, float *aResult);
+
+/**
+ * @brief   Append an axis-aligned box to the scene geometry
+ * @param   aMin [in] Minimum corner of the box
+ * @param   aMax [in] Maximum corner of the box
+ * @param   aColor [in] Colour of the box
+ * @param   aVertices [in/out] Vertices to append the corners to
+ */
+void addBox(const float *aMin, const float *aMax, const float *aColor,
+            std::vector<Vertex> &aVertices);
+
+/**
+ * @brief   Size the render targets to the framebuffer
+ * @param   aWidth [in] Width of the framebuffer in pixels
+ * @param   aHeight [in] Height of the framebuffer in pixels
+ * @param   aColorTexture [in] Colour texture to respecify
+ * @param   aDepthTexture [in] Depth texture to respecify
+ */
+void resizeTargets(int aWidth, int aHeight, GLuint aColorTexture,
+                   GLuint aDepthTexture);
+
+int main()
+{
+    glfwInit();
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR,
+                   GLANCE_GLFW_CONTEXT_VERSION_MAJOR);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR,
+                   GLANCE_GLFW_CONTEXT_VERSION_MINOR);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+    constexpr int windowWidth = 800;
+    constexpr int windowHeight = 600;
+    GLFWwindow *window = glfwCreateWindow(windowWidth, windowHeight, "Glance",
+                                          nullptr, nullptr);
+
+    if (!window)
+    {
+        std::cerr << "ERROR: Failed to create window." << std::endl;
+        glfwTerminate();
+        return -1;
+    }
+
+    glfwMakeContextCurrent(window);
+
+    if (!gladLoadGL())
+    {
+        std::cerr << "ERROR: Failed to create OpenGL context." << std::endl;
+        glfwTerminate();
+        return -1;
+    }
+    std::cerr << "INFO: Opengl " << glGetString(GL_VERSION) << std::endl;
+
+    Glance::ResourceRegistry &registry = Glance::ResourceRegistry::Default();
+    registry.QueryDeviceBudget();
+
+    // GL resources are scoped so they are released while the context is
+    // still alive.
+    {
+        Glance::Vfs vfs(Glance::Vfs::ExecutableDirectory() +
+                        "occlusion_example.pack");
+        Glance::Shader shader(vfs, "shader/occlusion_example_shader.vs",
+                              "shader/occlusion_example_shader.fs");
+        Glance::OcclusionCuller culler(
+            reinterpret_cast<GLADloadproc>(glfwGetProcAddress));
+
+        // Geometry
+        // A grid of small boxes split in half by a wall. All boxes share the
+        // same 36 indices and differ in their base vertex.
+        const GLuint boxIndices[] = {
+            0, 2, 1, 1, 2, 3,  /* -z */
+            4, 5, 6, 5, 7, 6,  /* +z */
+            0, 1, 4, 1, 5, 4,  /* -y */
+            2, 6, 3, 3, 6, 7,  /* +y */
+            0, 4, 2, 2, 4, 6,  /* -x */
+            1, 3, 5, 3, 7, 5}; /* +x */
+        constexpr int gridSize = 32;
+        constexpr float spacing = 2.f;
+        const float wallMin[3] = {-20.f, 0.f, -.5f};
+        const float wallMax[3] = {20.f, 12.f, .5f};
+        const float wallColor[3] = {.6f, .6f, .6f};
+
+        std::vector<Vertex> vertices;
+        std::vector<Glance::OcclusionObject> objects;
+        for (int row = 0; row < gridSize; ++row)
+        {
+            for (int column = 0; column < gridSize; ++column)
+            {
+                const float x = (column - gridSize / 2 + .5f) * spacing;
+                const float z = (row - gridSize / 2 + .5f) * spacing;
+                if (std::abs(z) < spacing && std::abs(x) <= wallMax[0])
+                {
+                    // Leave room for the wall
+                    continue;
+                }
+
+                const float min[3] = {x - .5f, 0.f, z - .5f};
+                const float max[3] = {x + .5f, 1.f, z + .5f};
+                const float color[3] = {static_cast<float>(column) / gridSize,
+                                        .5f,
+                                        static_cast<float>(row) / gridSize};
+                objects.push_back({{min[0], min[1], min[2]},
+                                   {max[0], max[1], max[2]},
+                                   36,
+                                   0,
+                                   static_cast<GLint>(vertices.size())});
+                addBox(min, max, color, vertices);
+            }
+        }
+        const GLint wallBaseVertex = static_cast<GLint>(vertices.size());
+        addBox(wallMin, wallMax, wallColor, vertices);
+        culler.SetObjects(objects);
+
+        GLuint vertexBufferObject;
+        glGenBuffers(1, &vertexBufferObject);
+
+        GLuint elementBufferObject;
+        glGenBuffers(1, &elementBufferObject);
+
+        GLuint vertexArrayObject;
+        glGenVertexArrays(1, &vertexArrayObject);
+
+        glBindVertexArray(vertexArrayObject);
+        glBindBuffer(GL_ARRAY_BUFFER, vertexBufferObject);
+        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex),
+                     vertices.data(), GL_STATIC_DRAW);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, elementBufferObject);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(boxIndices), boxIndices,
+                     GL_STATIC_DRAW);
+        glVertexAttribPointer(/* index         = */ 0,
+                              /* size          = */ 3,
+                              /* type          = */ GL_FLOAT,
+                              /* normalized    = */ GL_FALSE,
+                              /* stride        = */ sizeof(Vertex),
+                              /* offset        = */ (const void *)offsetof(Vertex, mPosition));
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(/* index         = */ 1,
+                              /* size          = */ 3,
+                              /* type          = */ GL_FLOAT,
+                              /* normalized    = */ GL_FALSE,
+                              /* stride        = */ sizeof(Vertex),
+                              /* offset        = */ (const void *)offsetof(Vertex, mColor));
+        glEnableVertexAttribArray(1);
+        glBindVertexArray(0);
+
+        Glance::ResourceId vertexBufferResource = registry.Register(
+            Glance::ResourceType::Buffer, vertices.size() * sizeof(Vertex),
+            "example:vertices");
+        Glance::ResourceId elementBufferResource = registry.Register(
+            Glance::ResourceType::Buffer, sizeof(boxIndices),
+            "example:indices");
+
+        // Render targets
+        // The scene is rendered into a depth texture, so the culler can build
+        // its depth pyramid from it, and then copied to the window.
+        GLuint colorTexture;
+        GLuint depthTexture;
+        glGenTextures(1, &colorTexture);
+        glGenTextures(1, &depthTexture);
+        for (GLuint texture : {colorTexture, depthTexture})
+        {
+            glBindTexture(GL_TEXTURE_2D, texture);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+        }
+
+        int targetWidth, targetHeight;
+        glfwGetFramebufferSize(window, &targetWidth, &targetHeight);
+        resizeTargets(targetWidth, targetHeight, colorTexture, depthTexture);
+
+        GLuint framebuffer;
+        glGenFramebuffers(1, &framebuffer);
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                               GL_TEXTURE_2D, colorTexture, 0);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT,
+                               GL_TEXTURE_2D, depthTexture, 0);
+        if (GL_FRAMEBUFFER_COMPLETE != glCheckFramebufferStatus(GL_FRAMEBUFFER))
+        {
+            std::cerr << "ERROR: Render targets are incomplete." << std::endl;
+        }
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+        Glance::ResourceId targetResource = registry.Register(
+            Glance::ResourceType::Texture,
+            static_cast<std::size_t>(targetWidth) * targetHeight * 8,
+            "example:targets");
+
+        double reportTime = glfwGetTime();
+        while (!glfwWindowShouldClose(window))
+        {
+            if (GLFW_PRESS == glfwGetKey(window, GLFW_KEY_ESCAPE))
+            {
+                glfwSetWindowShouldClose(window, true);
+            }
+
+            int width, height;
+            glfwGetFramebufferSize(window, &width, &height);
+            if (0 == width || 0 == height)
+            {
+                // Minimized, nothing to render into
+                glfwWaitEvents();
+                continue;
+            }
+            if (width != targetWidth || height != targetHeight)
+            {
+                targetWidth = width;
+                targetHeight = height;
+                resizeTargets(width, height, colorTexture, depthTexture);
+                registry.Resize(targetResource,
+                                static_cast<std::size_t>(width) * height * 8);
+            }
+
+            // Circle the wall at eye level, so it hides about half the grid
+            const double time = glfwGetTime();
+            const float angle = static_cast<float>(time) * .2f;
+            const float eye[3] = {45.f * std::cos(angle), 3.f,
+                                  45.f * std::sin(angle)};
+            const float center[3] = {0.f, 1.f, 0.f};
+            float projection[16];
+            float view[16];
+            float viewProjection[16];
+            perspective(1.f, static_cast<float>(width) / height, .1f, 200.f,
+                        projection);
+            lookAt(eye, center, view);
+            multiply(projection, view, viewProjection);
+
+            // Cull against the depth pyramid of the previous frame
+            culler.Cull(viewProjection);
+
+            glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+            glViewport(0, 0, width, height);
+            glEnable(GL_DEPTH_TEST);
+            glClearColor(.2f, .3f, .3f, 1.f);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+            shader.Use();
+            shader.SetMatrixUniform("viewProjection", viewProjection);
+            glBindVertexArray(vertexArrayObject);
+            glDrawElementsBaseVertex(
+                /* mode       = */ GL_TRIANGLES,
+                /* count      = */ 36,
+                /* type       = */ GL_UNSIGNED_INT,
+                /* indices    = */ (const void *)0,
+                /* basevertex = */ wallBaseVertex);
+            culler.Draw(GL_TRIANGLES, GL_UNSIGNED_INT);
+            glBindVertexArray(0);
+
+            glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+            glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+            glBlitFramebuffer(0, 0, width, height, 0, 0, width, height,
+                              GL_COLOR_BUFFER_BIT, GL_NEAREST);
+            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+            // The depth of this frame culls the next one
+            culler.BuildPyramid(depthTexture, width, height, viewProjection);
+
+            registry.Touch(vertexBufferResource);
+            registry.Touch(elementBufferResource);
+            registry.Touch(targetResource);
+            registry.EndFrame();
+
+            glfwSwapBuffers(window);
+            glfwPollEvents();
+
+            // Report the culling results once per second
+            if (time - reportTime >= 1.)
+            {
+                const Glance::OcclusionStats &stats = culler.Stats();
+                std::cerr << "INFO: Frame " << stats.mFrame << ": "
+                          << stats.mVisibleCount << " of "
+                          << stats.mObjectCount << " objects visible, "
+                          << stats.mCulledCount << " culled" << std::endl;
+                reportTime = time;
+            }
+        }
+
+        registry.Unregister(vertexBufferResource);
+        registry.Unregister(elementBufferResource);
+        registry.Unregister(targetResource);
+        glDeleteFramebuffers(1, &framebuffer);
+        glDeleteTextures(1, &colorTexture);
+        glDeleteTextures(1, &depthTexture);
+        glDeleteVertexArrays(1, &vertexArrayObject);
+        glDeleteBuffers(1, &vertexBufferObject);
+        glDeleteBuffers(1, &elementBufferObject);
+    }
+
+    glfwTerminate();
+    return 0;
+}
+
+void multiply(const float *aLeft, const float *aRight, float *aResult)
+{
+    for (int column = 0; column < 4; ++column)
+    {
+        for (int row = 0; row < 4; ++row)
+        {
+            float sum = 0.f;
+            for (int i = 0; i < 4; ++i)
+            {
+                sum += aLeft[i * 4 + row] * aRight[column * 4 + i];
+            }
+            aResult[column * 4 + row] = sum;
+        }
+    }
+}
+
+void perspective(float aFovY, float aAspect, float aNear, float aFar,
+                 float *aResult)
+{
+    const float f = 1.f / std::tan(aFovY / 2.f);
+    for (int i = 0; i < 16; ++i)
+    {
+        aResult[i] = 0.f;
+    }
+    aResult[0] = f / aAspect;
+    aResult[5] = f;
+    aResult[10] = (aFar + aNear) / (aNear - aFar);
+    aResult[11] = -1.f;
+    aResult[14] = 2.f * aFar * aNear / (aNear - aFar);
+}
+
+void lookAt(const float *aEye, const float *aCenter, float *aResult)
+{
+    auto normalize = [](float *aVector)
+    {
+        const float length = std::sqrt(aVector[0] * aVector[0] +
+                                       aVector[1] * aVector[1] +
+                                       aVector[2] * aVector[2]);
+        for (int i = 0; i < 3; ++i)
+        {
+            aVector[i] /= length;
+        }
+    };
+
+    // Forward, side and up axes of the camera, with the world up being +y
+    float forward[3] = {aCenter[0] - aEye[0], aCenter[1] - aEye[1],
+                        aCenter[2] - aEye[2]};
+    normalize(forward);
+    float side[3] = {-forward[2], 0.f, forward[0]};
+    normalize(side);
+    const float up[3] = {side[1] * forward[2] - side[2] * forward[1],
+                         side[2] * forward[0] - side[0] * forward[2],
+                         side[0] * forward[1] - side[1] * forward[0]};
+
+    const float matrix[16] = {
+        side[0], up[0], -forward[0], 0.f,
+        side[1], up[1], -forward[1], 0.f,
+        side[2], up[2], -forward[2], 0.f,
+        -(side[0] * aEye[0] + side[1] * aEye[1] + side[2] * aEye[2]),
+        -(up[0] * aEye[0] + up[1] * aEye[1] + up[2] * aEye[2]),
+        forward[0] * aEye[0] + forward[1] * aEye[1] + forward[2] * aEye[2],
+        1.f};
+    for (int i = 0; i < 16; ++i)
+    {
+        aResult[i] = matrix[i];
+    }
+}
+
+void addBox(const float *aMin, const float *aMax, const float *aColor,
+            std::vector<Vertex> &aVertices)
+{
+    // Corner i takes the maximum on x, y and z for bits 0, 1 and 2. Corners
+    // are shaded by their x and y bits so the faces of a box stand apart.
+    for (int i = 0; i < 8; ++i)
+    {
+        const float shade = .55f + .15f * (i & 1) + .3f * ((i >> 1) & 1);
+        aVertices.push_back({{(i & 1) ? aMax[0] : aMin[0],
+                              (i & 2) ? aMax[1] : aMin[1],
+                              (i & 4) ? aMax[2] : aMin[2]},
+                             {aColor[0] * shade, aColor[1] * shade,
+                              aColor[2] * shade}});
+    }
+}
+
+void resizeTargets(int aWidth, int aHeight, GLuint aColorTexture,
+                   GLuint aDepthTexture)
+{
+    glBindTexture(GL_TEXTURE_2D, aColorTexture);
+    glTexImage2D(/* target         = */ GL_TEXTURE_2D,
+                 /* level          = */ 0,
+                 /* internalFormat = */ GL_RGBA8,
+                 /* width          = */ aWidth,
+                 /* height         = */ aHeight,
+                 /* border         = */ 0,
+                 /* format         = */ GL_RGBA,
+                 /* type           = */ GL_UNSIGNED_BYTE,
+                 /* data           = */ nullptr);
+    glBindTexture(GL_TEXTURE_2D, aDepthTexture);
+    glTexImage2D(/* target         = */ GL_TEXTURE_2D,
+                 /* level          = */ 0,
+                 /* internalFormat = */ GL_DEPTH_COMPONENT24,
+                 /* width          = */ aWidth,
+                 /* height         = */ aHeight,
+                 /* border         = */ 0,
+                 /* format         = */ GL_DEPTH_COMPONENT,
+                 /* type           = */ GL_UNSIGNED_INT,
+                 /* data           = */ nullptr);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
@@ -0,0 +1,14 @@
+#version 400 core
+
+layout ( location = 0 ) in vec3 aPos;
+layout ( location = 1 ) in vec3 aColor;
+
+out vec3 color;
+
+uniform mat4 viewProjection;
+
+void main()
+{
+    gl_Position = viewProjection * vec4( aPos, 1.0 );
+    color = aColor;
+}
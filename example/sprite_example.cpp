@@ -0,0 +1,183 @@
+/**
+ * Copyright 2021 Christoph Groß
+ *
+ * This file is part of Glance.
+ *
+ * Glance is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Glance is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Glance.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include "glance.hpp"
+
+/**
+ * @brief   A sprite bouncing around the window
+ */
+struct BouncingSprite
+{
+    float mX;
+    float mY;
+    float mVelocityX;
+    float mVelocityY;
+    std::uint32_t mColor;
+};
+
+int main()
+{
+    glfwInit();
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR,
+                   GLANCE_GLFW_CONTEXT_VERSION_MAJOR);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR,
+                   GLANCE_GLFW_CONTEXT_VERSION_MINOR);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+    constexpr int windowWidth = 800;
+    constexpr int windowHeight = 600;
+    GLFWwindow *window = glfwCreateWindow(windowWidth, windowHeight, "Glance",
+                                          nullptr, nullptr);
+
+    if (!window)
+    {
+        std::cerr << "ERROR: Failed to create window." << std::endl;
+        glfwTerminate();
+        return -1;
+    }
+
+    glfwMakeContextCurrent(window);
+    // Do not wait for vertical sync, so the frame time can be measured
+    glfwSwapInterval(0);
+
+    if (!gladLoadGL())
+    {
+        std::cerr << "ERROR: Failed to create OpenGL context." << std::endl;
+        glfwTerminate();
+        return -1;
+    }
+    std::cerr << "INFO: Opengl " << glGetString(GL_VERSION) << std::endl;
+
+    Glance::ResourceRegistry &registry = Glance::ResourceRegistry::Default();
+    registry.QueryDeviceBudget();
+
+    glViewport(0, 0, windowWidth, windowHeight);
+    glfwSetFramebufferSizeCallback(window,
+                                   [](GLFWwindow *, int aWidth, int aHeight)
+                                   {
+                                       glViewport(0, 0, aWidth, aHeight);
+                                   });
+
+    // GL resources are scoped so they are released while the context is
+    // still alive.
+    {
+        Glance::Vfs vfs(Glance::Vfs::ExecutableDirectory() +
+                        "sprite_example.pack");
+        Glance::Texture texture(vfs, "texture/container.jpg");
+        Glance::Font font(vfs, "font/SourceCodePro-Regular.ttf", 18.f);
+        Glance::SpriteBatch batch;
+
+        constexpr std::size_t spriteCount = 100000;
+        constexpr float spriteSize = 8.f;
+        std::mt19937 random(0);
+        std::uniform_real_distribution<float> position(0.f, 1.f);
+        std::uniform_real_distribution<float> velocity(-100.f, 100.f);
+        std::uniform_int_distribution<int> channel(64, 255);
+        std::vector<BouncingSprite> sprites(spriteCount);
+        for (BouncingSprite &sprite : sprites)
+        {
+            sprite = {position(random) * (windowWidth - spriteSize),
+                      position(random) * (windowHeight - spriteSize),
+                      velocity(random), velocity(random),
+                      Glance::PackColor(channel(random), channel(random),
+                                        channel(random))};
+        }
+
+        double lastTime = glfwGetTime();
+        double reportTime = lastTime;
+        unsigned frames = 0;
+        std::string hud;
+        while (!glfwWindowShouldClose(window))
+        {
+            if (GLFW_PRESS == glfwGetKey(window, GLFW_KEY_ESCAPE))
+            {
+                glfwSetWindowShouldClose(window, true);
+            }
+
+            const double time = glfwGetTime();
+            const float delta = static_cast<float>(time - lastTime);
+            lastTime = time;
+
+            int width, height;
+            glfwGetFramebufferSize(window, &width, &height);
+
+            glClearColor(.2f, .3f, .3f, 1.f);
+            glClear(GL_COLOR_BUFFER_BIT);
+
+            // Submission order keeps the HUD on top. The sprites share one
+            // texture, so they batch just as well as with texture sorting.
+            batch.Begin(width, height, Glance::SpriteSortMode::Submission);
+            for (BouncingSprite &sprite : sprites)
+            {
+                sprite.mX += sprite.mVelocityX * delta;
+                sprite.mY += sprite.mVelocityY * delta;
+                if (sprite.mX < 0.f || sprite.mX > width - spriteSize)
+                {
+                    sprite.mVelocityX = -sprite.mVelocityX;
+                }
+                if (sprite.mY < 0.f || sprite.mY > height - spriteSize)
+                {
+                    sprite.mVelocityY = -sprite.mVelocityY;
+                }
+                batch.Draw(texture,
+                           {sprite.mX, sprite.mY, spriteSize, spriteSize},
+                           {0.f, 0.f, 1.f, 1.f}, sprite.mColor);
+            }
+            const float hudX = 10.f;
+            const float hudY = 10.f + font.LineHeight();
+            font.Draw(batch, hud, hudX + 1.f, hudY + 1.f,
+                      Glance::PackColor(0, 0, 0));
+            font.Draw(batch, hud, hudX, hudY);
+            batch.End();
+            registry.EndFrame();
+
+            glfwSwapBuffers(window);
+            glfwPollEvents();
+
+            // Update the average frame time once per second
+            ++frames;
+            if (time - reportTime >= 1.)
+            {
+                std::ostringstream text;
+                text << batch.SpriteCount() << " sprites\n"
+                     << batch.DrawCallCount() << " draw calls\n"
+                     << std::fixed << std::setprecision(2)
+                     << 1000. * (time - reportTime) / frames
+                     << " ms per frame";
+                hud = text.str();
+                reportTime = time;
+                frames = 0;
+            }
+        }
+    }
+
+    glfwTerminate();
+    return 0;
+}
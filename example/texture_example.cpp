@@ -22,8 +22,6 @@
 
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
-#define STB_IMAGE_IMPLEMENTATION
-#include <stb_image.h>
 
 #include "glance.hpp"
 
@@ -70,6 +68,13 @@ int main()
     }
     std::cerr << "INFO: Opengl " << glGetString(GL_VERSION) << std::endl;
 
+    Glance::ResourceRegistry &registry = Glance::ResourceRegistry::Default();
+    if (!registry.QueryDeviceBudget())
+    {
+        std::cerr << "INFO: No GPU memory info available, using a budget of "
+                  << (registry.Budget() >> 20) << " MiB" << std::endl;
+    }
+
     glViewport(0, 0, windowWidth, windowHeight);
     glfwSetFramebufferSizeCallback(window,
                                    [](GLFWwindow *, int aWidth, int aHeight)
@@ -77,118 +82,109 @@ int main()
                                        glViewport(0, 0, aWidth, aHeight);
                                    });
 
-    /**
-     * @todo #3 This currently only works when the program is invoked from
-     *          within it's own directory. Some logic should be added to find
-     *          the shaders independent of the current location in the
-     *          filesystem.
-     */
-    Glance::Shader shader = Glance::Shader("texture_example_shader.vs",
-                                           "texture_example_shader.fs");
-
-    // Texture
-    GLuint texture;
-    glGenTextures(1, &texture);
-    glBindTexture(GL_TEXTURE_2D, texture);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_MIRRORED_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_MIRRORED_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-    int textureWidth, textureHeight, textureChannels;
-    stbi_uc *textureData = stbi_load("container.jpg", &textureWidth,
-                                     &textureHeight, &textureChannels,
-                                     /* magic number? */ 0);
-    if (textureData)
-    {
-        glTexImage2D(/* target         = */ GL_TEXTURE_2D,
-                     /* level          = */ 0,
-                     /* internalFormat = */ GL_RGB,
-                     /* width          = */ textureWidth,
-                     /* height         = */ textureHeight,
-                     /* border         = */ 0,
-                     /* format         = */ GL_RGB,
-                     /* type           = */ GL_UNSIGNED_BYTE,
-                     /* data           = */ textureData);
-        glGenerateMipmap(GL_TEXTURE_2D);
-    }
-    else
-    {
-        std::cerr << "ERROR: Could not load texture." << std::endl;
-    }
-    stbi_image_free(textureData);
-
-    // Geometry
-    // Each vertex consists of 8 floats that encode the following properties:
-    // x-pos, y-pos, z-pos, r-color, g-color, b-color, x-texture-pos, y-texture-pos
-    float vertices[] = {
-        /* top-right    */ 0.5f, 0.5f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f,
-        /* bottom right */ 0.5f, -0.5f, 0.0f, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f,
-        /* bottom left  */ -0.5f, -0.5f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f,
-        /* top left     */ -0.5f, 0.5f, 0.0f, 1.0f, 1.0f, 0.0f, 0.0f, 1.0f};
-    GLuint indices[] = {
-        0, 1, 2,
-        2, 3, 0};
-
-    GLuint vertexBufferObject;
-    glGenBuffers(1, &vertexBufferObject);
-
-    GLuint elementBufferObject;
-    glGenBuffers(1, &elementBufferObject);
-
-    GLuint vertexArrayObject;
-    glGenVertexArrays(1, &vertexArrayObject);
-
-    glBindVertexArray(vertexArrayObject);
-    glBindBuffer(GL_ARRAY_BUFFER, vertexBufferObject);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices,
-                 GL_STATIC_DRAW);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, elementBufferObject);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices,
-                 GL_STATIC_DRAW);
-    glVertexAttribPointer(/* index         = */ 0,
-                          /* size          = */ 3,
-                          /* type          = */ GL_FLOAT,
-                          /* normalized    = */ GL_FALSE,
-                          /* stride        = */ 8 * sizeof(float),
-                          /* offset        = */ (const void *)0);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(/* index         = */ 1,
-                          /* size          = */ 3,
-                          /* type          = */ GL_FLOAT,
-                          /* normalized    = */ GL_FALSE,
-                          /* stride        = */ 8 * sizeof(float),
-                          /* offset        = */ (const void *)(3 * sizeof(float)));
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(/* index         = */ 2,
-                          /* size          = */ 2,
-                          /* type          = */ GL_FLOAT,
-                          /* normalized    = */ GL_FALSE,
-                          /* stride        = */ 8 * sizeof(float),
-                          /* offset        = */ (const void *)(6 * sizeof(float)));
-    glEnableVertexAttribArray(2);
-
-    while (!glfwWindowShouldClose(window))
+    // GL resources are scoped so they are released while the context is
+    // still alive.
     {
-        processInput(window);
+        // The asset pack is located next to the executable, so the example can
+        // be invoked from anywhere in the filesystem.
+        Glance::Vfs vfs(Glance::Vfs::ExecutableDirectory() +
+                        "texture_example.pack");
+        Glance::Shader shader(vfs, "shader/texture_example_shader.vs",
+                              "shader/texture_example_shader.fs");
+
+        // Texture
+        Glance::Texture texture(vfs, "texture/container.jpg");
+        texture.Bind();
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_MIRRORED_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_MIRRORED_REPEAT);
+
+        // Geometry
+        // Each vertex consists of 8 floats that encode the following properties:
+        // x-pos, y-pos, z-pos, r-color, g-color, b-color, x-texture-pos, y-texture-pos
+        float vertices[] = {
+            /* top-right    */ 0.5f, 0.5f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f,
+            /* bottom right */ 0.5f, -0.5f, 0.0f, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f,
+            /* bottom left  */ -0.5f, -0.5f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f,
+            /* top left     */ -0.5f, 0.5f, 0.0f, 1.0f, 1.0f, 0.0f, 0.0f, 1.0f};
+        GLuint indices[] = {
+            0, 1, 2,
+            2, 3, 0};
+
+        GLuint vertexBufferObject;
+        glGenBuffers(1, &vertexBufferObject);
+
+        GLuint elementBufferObject;
+        glGenBuffers(1, &elementBufferObject);
+
+        GLuint vertexArrayObject;
+        glGenVertexArrays(1, &vertexArrayObject);
 
-        // Clear background
-        glClearColor(.2f, .3f, .3f, 1.f);
-        glClear(GL_COLOR_BUFFER_BIT);
-
-        shader.Use();
-        glBindTexture(GL_TEXTURE_2D, texture);
         glBindVertexArray(vertexArrayObject);
+        glBindBuffer(GL_ARRAY_BUFFER, vertexBufferObject);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices,
+                     GL_STATIC_DRAW);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, elementBufferObject);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices,
+                     GL_STATIC_DRAW);
+        glVertexAttribPointer(/* index         = */ 0,
+                              /* size          = */ 3,
+                              /* type          = */ GL_FLOAT,
+                              /* normalized    = */ GL_FALSE,
+                              /* stride        = */ 8 * sizeof(float),
+                              /* offset        = */ (const void *)0);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(/* index         = */ 1,
+                              /* size          = */ 3,
+                              /* type          = */ GL_FLOAT,
+                              /* normalized    = */ GL_FALSE,
+                              /* stride        = */ 8 * sizeof(float),
+                              /* offset        = */ (const void *)(3 * sizeof(float)));
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(/* index         = */ 2,
+                              /* size          = */ 2,
+                              /* type          = */ GL_FLOAT,
+                              /* normalized    = */ GL_FALSE,
+                              /* stride        = */ 8 * sizeof(float),
+                              /* offset        = */ (const void *)(6 * sizeof(float)));
+        glEnableVertexAttribArray(2);
+
+        Glance::ResourceId vertexBufferResource = registry.Register(
+            Glance::ResourceType::Buffer, sizeof(vertices), "example:vertices");
+        Glance::ResourceId elementBufferResource = registry.Register(
+            Glance::ResourceType::Buffer, sizeof(indices), "example:indices");
+
+        while (!glfwWindowShouldClose(window))
+        {
+            processInput(window);
+
+            // Clear background
+            glClearColor(.2f, .3f, .3f, 1.f);
+            glClear(GL_COLOR_BUFFER_BIT);
+
+            shader.Use();
+            texture.Bind();
+            glBindVertexArray(vertexArrayObject);
 
-        glDrawElements(
-            /* mode     = */ GL_TRIANGLES,
-            /* count    = */ 6,
-            /* type     = */ GL_UNSIGNED_INT,
-            /* indices  = */ (const void *)0);
+            glDrawElements(
+                /* mode     = */ GL_TRIANGLES,
+                /* count    = */ 6,
+                /* type     = */ GL_UNSIGNED_INT,
+                /* indices  = */ (const void *)0);
 
-        glfwSwapBuffers(window);
+            registry.Touch(vertexBufferResource);
+            registry.Touch(elementBufferResource);
+            registry.EndFrame();
+
+            glfwSwapBuffers(window);
+
+            glfwPollEvents();
+        }
 
-        glfwPollEvents();
+        registry.Unregister(vertexBufferResource);
+        registry.Unregister(elementBufferResource);
+        glDeleteVertexArrays(1, &vertexArrayObject);
+        glDeleteBuffers(1, &vertexBufferObject);
+        glDeleteBuffers(1, &elementBufferObject);
     }
 
     glfwTerminate();
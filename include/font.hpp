@@ -0,0 +1,216 @@
+/**
+ * Copyright 2021 Christoph Groß
+ *
+ * This file is part of Glance.
+ *
+ * Glance is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Glance is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Glance.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef GLANCE_FONT_HPP
+#define GLANCE_FONT_HPP
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <exception>
+#include <vector>
+
+#include <glad/glad.h>
+
+#include "resource_registry.hpp"
+#include "sprite_batch.hpp"
+#include "vfs.hpp"
+
+namespace Glance
+{
+
+    class FontAtlas
+    {
+    public:
+        /**
+         * @brief   Placement of a glyph in the atlas, see stbtt_bakedchar
+         */
+        struct Glyph
+        {
+            unsigned short mX0;
+            unsigned short mY0;
+            unsigned short mX1;
+            unsigned short mY1;
+            float mOffsetX;
+            float mOffsetY;
+            float mAdvance;
+        };
+
+        /**
+         * @brief   Constructor
+         * @details The constructor rasterizes the printable ASCII characters
+         *          of a TrueType font into a single channel coverage bitmap.
+         *          No OpenGL context is required.
+         * @throw   Throws FontException in case of unrecoverable error.
+         * @param   aData [in] Contents of the TrueType font file
+         * @param   aName [in] Name of the font used in error messages
+         * @param   aPixelHeight [in] Height of the rasterized glyphs in pixels
+         */
+        FontAtlas(
+            std::string_view aData,
+            const std::string &aName,
+            float aPixelHeight);
+
+        /**
+         * @brief   Placement of a character in the atlas
+         * @return  Pointer to the glyph or nullptr for characters outside the
+         *          printable ASCII range
+         */
+        const Glyph *Find(
+            char aCharacter) const noexcept;
+
+        /**
+         * @brief   Width of the widest line of a text in pixels
+         * @param   aText [in] Text to measure
+         */
+        float Measure(
+            std::string_view aText) const noexcept;
+
+        /**
+         * @brief   Distance between two baselines in pixels
+         */
+        float LineHeight() const noexcept;
+
+        /**
+         * @brief   Width of the atlas in pixels
+         */
+        int Width() const noexcept;
+
+        /**
+         * @brief   Height of the atlas in pixels
+         */
+        int Height() const noexcept;
+
+        /**
+         * @brief   Coverage of the atlas, one byte per pixel, rows top down
+         */
+        const std::vector<unsigned char> &Bitmap() const noexcept;
+
+    private:
+        // First character in the atlas
+        static constexpr int FirstCharacter = 32;
+        // Number of characters in the atlas
+        static constexpr int CharacterCount = 95;
+
+        // Placement of the glyphs in the atlas
+        std::vector<Glyph> mGlyphs;
+        // Coverage of the atlas
+        std::vector<unsigned char> mBitmap;
+        // Width of the atlas in pixels
+        int mWidth;
+        // Height of the atlas in pixels
+        int mHeight;
+        // Distance between two baselines in pixels
+        float mLineHeight;
+    };
+
+    class Font
+    {
+    public:
+        /**
+         * @brief   Constructor
+         * @details The constructor rasterizes the printable ASCII characters
+         *          of a TrueType font into a single glyph atlas texture. The
+         *          font file is only read during construction.
+         * @throw   Throws FontException in case of unrecoverable error.
+         * @param   aVfs [in] Asset pack containing the font
+         * @param   aPath [in] Path to the TrueType font inside the asset pack
+         * @param   aPixelHeight [in] Height of the rasterized glyphs in pixels
+         */
+        Font(
+            const Vfs &aVfs,
+            const std::string &aPath,
+            float aPixelHeight);
+
+        /**
+         * @brief   Destructor
+         * @details Delete the glyph atlas. The OpenGL context the font was
+         *          created in has to be current.
+         */
+        ~Font();
+
+        Font(const Font &) = delete;
+        Font &operator=(const Font &) = delete;
+
+        /**
+         * @brief   Queue text for drawing
+         * @details Queue one sprite per glyph with the given sprite batch.
+         *          Characters outside the printable ASCII range are skipped
+         *          and newlines start a new line.
+         * @param   aBatch [in/out] Sprite batch to queue the glyphs with
+         * @param   aText [in] Text to draw
+         * @param   aX [in] Left edge of the text in pixels
+         * @param   aY [in] Baseline of the first line in pixels
+         * @param   aColor [in] Colour of the text, see PackColor
+         */
+        void Draw(
+            SpriteBatch &aBatch,
+            std::string_view aText,
+            float aX,
+            float aY,
+            std::uint32_t aColor = PackColor(255, 255, 255)) const;
+
+        /**
+         * @brief   Width of the widest line of a text in pixels
+         * @param   aText [in] Text to measure
+         */
+        float Measure(
+            std::string_view aText) const noexcept;
+
+        /**
+         * @brief   Distance between two baselines in pixels
+         */
+        float LineHeight() const noexcept;
+
+    private:
+        // Glyph placement and metrics
+        FontAtlas mAtlas;
+        // ID of the glyph atlas texture
+        GLuint mTextureId;
+        // Handle of the atlas in the default resource registry
+        ResourceId mResourceId;
+    };
+
+    class FontException : public std::exception
+    {
+    public:
+        /**
+         * @brief   Constructor
+         * @details Construct a FontException object with information on the
+         *          error that occured.
+         * @param   aErrorMsg [in] Descriptive error string explaining what went
+         *          wrong
+         */
+        FontException(
+            std::string aErrorMsg) noexcept;
+
+        /**
+         * @brief   Description of the exception
+         */
+        const char *what() const noexcept override;
+
+    private:
+        // A descriptive error message
+        std::string mErrorMsg;
+    };
+
+} // namespace Glance
+
+#endif // GLANCE_FONT_HPP
@@ -20,7 +20,13 @@
 #ifndef GLANCE
 #define GLANCE
 
+#include "font.hpp"
+#include "occlusion_culler.hpp"
+#include "resource_registry.hpp"
 #include "shader.hpp"
+#include "sprite_batch.hpp"
+#include "texture.hpp"
+#include "vfs.hpp"
 
 /**
  * @brief   Major version of GLFW to use with Glance
@@ -0,0 +1,325 @@
+/**
+ * Copyright 2021 Christoph Groß
+ *
+ * This file is part of Glance.
+ *
+ * Glance is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Glance is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Glance.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef GLANCE_OCCLUSION_CULLER_HPP
+#define GLANCE_OCCLUSION_CULLER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <glad/glad.h>
+
+#include "resource_registry.hpp"
+#include "shader.hpp"
+
+namespace Glance
+{
+
+    /**
+     * @brief   An object subject to occlusion culling
+     * @details Holds the world space bounding box of an object and the
+     *          parameters of the indexed draw call rendering it.
+     */
+    struct OcclusionObject
+    {
+        float mBoundsMin[3];
+        float mBoundsMax[3];
+        GLuint mCount;
+        GLuint mFirstIndex;
+        GLint mBaseVertex;
+    };
+
+    /**
+     * @brief   Culling results of a single frame
+     */
+    struct OcclusionStats
+    {
+        // Frame the results were recorded for, counting calls to Cull
+        std::uint64_t mFrame;
+        // Number of objects tested
+        std::size_t mObjectCount;
+        // Number of objects that passed the frustum and occlusion test
+        std::size_t mVisibleCount;
+        // Number of objects culled
+        std::size_t mCulledCount;
+    };
+
+    namespace detail
+    {
+
+        /**
+         * @brief   Texels of the depth pyramid covering a screen rectangle
+         * @details Minimum and maximum texel are inclusive and at most one texel
+         *          apart on each axis, so four fetches cover the rectangle.
+         */
+        struct HiZTexelRange
+        {
+            int mLevel;
+            int mMinX;
+            int mMinY;
+            int mMaxX;
+            int mMaxY;
+        };
+
+        /**
+         * @brief   Size of a level of the depth pyramid
+         * @details Levels halve in size, rounding down, like regular mip levels.
+         *          The odd last row or column of a level is folded into the last
+         *          texel of the next level.
+         * @param   aBaseSize [in] Size of level 0 in texels
+         * @param   aLevel [in] Level of the pyramid
+         * @return  Size of the level in texels
+         */
+        int HiZLevelSize(
+            int aBaseSize,
+            int aLevel) noexcept;
+
+        /**
+         * @brief   Select the depth pyramid texels to test a screen rectangle
+         * @details Map the rectangle to its texels in level 0 first, then pick
+         *          the coarsest level needed for a 2x2 footprint and shift the
+         *          texels down to that level. Rounding in level 0 and clamping to
+         *          the last texel of the level keeps the range conservative with
+         *          sizes that are not a power of two. CPU reference of the
+         *          selection in the culling shader, which must be kept in sync.
+         * @param   aMinU [in] Left edge of the rectangle, 0 to 1
+         * @param   aMinV [in] Bottom edge of the rectangle, 0 to 1
+         * @param   aMaxU [in] Right edge of the rectangle, 0 to 1
+         * @param   aMaxV [in] Top edge of the rectangle, 0 to 1
+         * @param   aWidth [in] Width of level 0 in texels
+         * @param   aHeight [in] Height of level 0 in texels
+         * @param   aLevels [in] Number of levels of the pyramid
+         * @return  Level and texels to fetch
+         */
+        HiZTexelRange SelectHiZTexels(
+            float aMinU,
+            float aMinV,
+            float aMaxU,
+            float aMaxV,
+            int aWidth,
+            int aHeight,
+            int aLevels) noexcept;
+
+    } // namespace detail
+
+    class OcclusionCuller
+    {
+    public:
+        /**
+         * @brief   Constructor
+         * @details Create the shader programs and OpenGL objects used for
+         *          building the depth pyramid and culling. Requires a current
+         *          OpenGL context.
+         * @param   aLoader [in] Function returning OpenGL entry points, the
+         *          same one passed to gladLoadGLLoader. Used to load
+         *          glMultiDrawElementsIndirect where the driver supports
+         *          it, without a loader every object is drawn separately
+         */
+        explicit OcclusionCuller(GLADloadproc aLoader = nullptr);
+
+        /**
+         * @brief   Destructor
+         * @details Delete all OpenGL objects of the culler. The OpenGL context
+         *          the culler was created in has to be current.
+         */
+        ~OcclusionCuller();
+
+        OcclusionCuller(const OcclusionCuller &) = delete;
+        OcclusionCuller &operator=(const OcclusionCuller &) = delete;
+
+        /**
+         * @brief   Set the objects to cull
+         * @details Upload the bounds and draw parameters of all objects. The
+         *          index of an object in aObjects is the index of its command
+         *          in the indirect draw buffer.
+         * @param   aObjects [in] Objects to cull
+         */
+        void SetObjects(
+            const std::vector<OcclusionObject> &aObjects);
+
+        /**
+         * @brief   Build the depth pyramid
+         * @details Reduce a depth texture into a mip-chained pyramid holding
+         *          the farthest depth of each region. Call this once a frame
+         *          is rendered, so the next frame can be culled against it.
+         * @note    Assumes the default depth range and depth function, i.e.
+         *          larger depth values being farther away, and a complete
+         *          depth texture without compare mode. Changes the current
+         *          program, makes texture unit 0 active and changes its
+         *          GL_TEXTURE_2D binding, and leaves vertex array object 0
+         *          bound. Framebuffer, viewport, depth test and blending are
+         *          restored.
+         * @param   aDepthTexture [in] Depth texture of the rendered frame
+         * @param   aWidth [in] Width of the depth texture in pixels
+         * @param   aHeight [in] Height of the depth texture in pixels
+         * @param   aViewProjection [in] View-projection matrix the frame was
+         *          rendered with, 16 floats in column-major order
+         */
+        void BuildPyramid(
+            GLuint aDepthTexture,
+            int aWidth,
+            int aHeight,
+            const float *aViewProjection);
+
+        /**
+         * @brief   Cull the objects
+         * @details Test all objects against the view frustum and the depth
+         *          pyramid and write one indirect draw command per object.
+         *          Culled objects get an instance count of zero, so they never
+         *          reach the vertex stage. Objects are tested against the
+         *          pyramid with the matrix it was built with, so this is
+         *          conservative for objects that moved since. Everything
+         *          passes the occlusion test until a pyramid was built.
+         * @note    Changes the current program, makes texture unit 0 active
+         *          and changes its GL_TEXTURE_2D binding, and leaves vertex
+         *          array object 0 bound. Bind the program, textures and
+         *          vertex array object to draw with after calling this.
+         * @param   aViewProjection [in] View-projection matrix of the frame
+         *          to render, 16 floats in column-major order
+         */
+        void Cull(
+            const float *aViewProjection);
+
+        /**
+         * @brief   Draw the surviving objects
+         * @details Issue the indirect draw commands written by Cull with a
+         *          single glMultiDrawElementsIndirect call where
+         *          GL_ARB_multi_draw_indirect is available and the culler was
+         *          given a loader, or one glDrawElementsIndirect call per
+         *          object otherwise. The
+         *          vertex array object and shader program to draw with have
+         *          to be bound by the caller.
+         * @param   aMode [in] Primitive type, e.g. GL_TRIANGLES
+         * @param   aIndexType [in] Type of the indices in the element buffer
+         * @param   aFirst [in] Index of the first object to draw
+         * @param   aCount [in] Number of objects to draw, by default all
+         *          remaining objects
+         */
+        void Draw(
+            GLenum aMode,
+            GLenum aIndexType,
+            std::size_t aFirst = 0,
+            std::size_t aCount = static_cast<std::size_t>(-1)) const;
+
+        /**
+         * @brief   ID of the indirect draw buffer
+         * @details The buffer holds one DrawElementsIndirectCommand per
+         *          object, e.g. for drawing with a custom vertex setup.
+         */
+        GLuint CommandBuffer() const noexcept;
+
+        /**
+         * @brief   Latest culling results read back from the GPU
+         * @details Results are read back asynchronously and lag a few frames
+         *          behind, so reading them never stalls the pipeline.
+         */
+        const OcclusionStats &Stats() const noexcept;
+
+    private:
+        /**
+         * @brief   Layout of an indirect draw command, see glDrawElementsIndirect
+         */
+        struct DrawCommand
+        {
+            GLuint mCount;
+            GLuint mInstanceCount;
+            GLuint mFirstIndex;
+            GLint mBaseVertex;
+            GLuint mBaseInstance;
+        };
+
+        /**
+         * @brief   Copy of the draw commands on its way back to the CPU
+         */
+        struct Readback
+        {
+            GLuint mBuffer;
+            std::size_t mCapacity;
+            GLsync mFence;
+            std::uint64_t mFrame;
+            std::size_t mObjectCount;
+        };
+
+        /**
+         * @brief   Signature of glMultiDrawElementsIndirect
+         */
+        using MultiDrawElementsIndirectFunction = void(APIENTRYP)(
+            GLenum aMode,
+            GLenum aType,
+            const void *aIndirect,
+            GLsizei aDrawCount,
+            GLsizei aStride);
+
+        // Number of readbacks that may be in flight at the same time
+        static constexpr std::size_t ReadbackCount = 3;
+
+        // Shader program copying the depth texture into the pyramid
+        Shader mCopyShader;
+        // Shader program reducing a pyramid level into the next one
+        Shader mReduceShader;
+        // Shader program culling the objects with transform feedback
+        Shader mCullShader;
+        // ID of an empty vertex array object for fullscreen passes
+        GLuint mEmptyVertexArrayObject;
+        // ID of the vertex array object reading the objects
+        GLuint mObjectVertexArrayObject;
+        // ID of the buffer holding the objects
+        GLuint mObjectBuffer;
+        // ID of the indirect draw buffer written by Cull
+        GLuint mCommandBuffer;
+        // ID of the framebuffer rendering into the pyramid
+        GLuint mFramebuffer;
+        // ID of the depth pyramid texture
+        GLuint mPyramidTexture;
+        // Width of the base level of the pyramid in pixels
+        int mPyramidWidth;
+        // Height of the base level of the pyramid in pixels
+        int mPyramidHeight;
+        // Number of levels of the pyramid, 0 until it is built
+        int mPyramidLevels;
+        // View-projection matrix the pyramid was built with
+        float mPyramidViewProjection[16];
+        // Number of objects to cull
+        std::size_t mObjectCount;
+        // Number of calls to Cull
+        std::uint64_t mFrame;
+        // Copies of the draw commands in flight
+        Readback mReadbacks[ReadbackCount];
+        // Latest culling results
+        OcclusionStats mStats;
+        // glMultiDrawElementsIndirect, which is not part of OpenGL 4.0, or
+        // nullptr in case GL_ARB_multi_draw_indirect is not available
+        MultiDrawElementsIndirectFunction mMultiDrawElementsIndirect;
+        // Handles of the buffers and the pyramid in the default registry
+        ResourceId mObjectResource;
+        ResourceId mCommandResource;
+        ResourceId mPyramidResource;
+        ResourceId mReadbackResource;
+
+        /**
+         * @brief   Collect readbacks the GPU has finished without waiting
+         */
+        void PollReadbacks();
+    };
+
+} // namespace Glance
+
+#endif // GLANCE_OCCLUSION_CULLER_HPP
@@ -0,0 +1,333 @@
+/**
+ * Copyright 2021 Christoph Groß
+ *
+ * This file is part of Glance.
+ *
+ * Glance is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Glance is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Glance.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef GLANCE_RESOURCE_REGISTRY_HPP
+#define GLANCE_RESOURCE_REGISTRY_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace Glance
+{
+
+    /**
+     * @brief   Handle of a resource registered with a ResourceRegistry
+     * @details The lower ResourceIndexBits bits hold the slot of the resource
+     *          plus one, the upper bits hold the generation of the slot. The
+     *          generation changes whenever a slot is released, so handles of
+     *          unregistered resources stay invalid when the slot is reused.
+     *          0 is never a valid handle.
+     */
+    using ResourceId = std::uint32_t;
+
+    /// Number of bits of a ResourceId holding the slot
+    constexpr unsigned ResourceIndexBits = 20;
+
+    /**
+     * @brief   Kind of a registered GPU resource
+     */
+    enum class ResourceType
+    {
+        Texture,
+        Buffer
+    };
+
+    /**
+     * @brief   Residency statistics of a single frame
+     */
+    struct ResidencyStats
+    {
+        // Frame the statistics were recorded for
+        std::uint64_t mFrame;
+        // Memory budget in effect for the frame in bytes
+        std::size_t mBudgetBytes;
+        // Memory used by all registered resources in bytes
+        std::size_t mResidentBytes;
+        // Memory used by registered textures in bytes
+        std::size_t mTextureBytes;
+        // Memory used by registered buffers in bytes
+        std::size_t mBufferBytes;
+        // Number of registered resources
+        std::size_t mResourceCount;
+        // Number of resources used during the frame
+        std::size_t mUsedCount;
+        // Number of resources currently held at reduced size
+        std::size_t mReducedCount;
+        // Number of resources shrunk at the end of the frame
+        std::size_t mEvictions;
+        // Number of resources restored at the end of the frame
+        std::size_t mRestores;
+    };
+
+    class ResourceRegistry
+    {
+    public:
+        /**
+         * @brief   Evict part of a streamable resource
+         * @details Called with the number of bytes the registry is over
+         *          budget. The callback frees that much memory in a single
+         *          step where it can, e.g. by dropping as many mip levels as
+         *          needed at once, and returns the new size of the resource
+         *          in bytes. Freeing less is fine, the next resource makes up
+         *          for it. Returning the unchanged size marks the resource as
+         *          not evictable any further.
+         */
+        using EvictCallback = std::function<std::size_t(
+            std::size_t aBytesToFree)>;
+
+        /**
+         * @brief   Restore a previously evicted resource
+         * @details Called once enough budget is available again. The callback
+         *          brings the resource back to full size and returns its new
+         *          size in bytes.
+         */
+        using RestoreCallback = std::function<std::size_t()>;
+
+        /**
+         * @brief   Query the memory currently free on the device
+         * @details Called at the end of each frame. Returns the free device
+         *          memory in bytes, which does not include the memory of the
+         *          registered resources.
+         */
+        using FreeMemorySource = std::function<std::size_t()>;
+
+        /**
+         * @brief   Constructor
+         * @param   aFallbackBudgetBytes [in] Memory budget in bytes used as
+         *          long as no free memory source is installed
+         */
+        explicit ResourceRegistry(
+            std::size_t aFallbackBudgetBytes);
+
+        /**
+         * @brief   Registry shared by all Glance resources
+         * @details Textures and buffers created by Glance register themselves
+         *          with this registry. Its fallback budget is 256 MiB.
+         */
+        static ResourceRegistry &Default();
+
+        /**
+         * @brief   Query the memory available on the device
+         * @details Install a free memory source using GL_NVX_gpu_memory_info
+         *          or GL_ATI_meminfo, whichever is present. Requires a current
+         *          OpenGL context.
+         * @return  true in case one of the extensions is present and
+         *          false in case the fallback budget is used.
+         */
+        bool QueryDeviceBudget();
+
+        /**
+         * @brief   Set the source of the free device memory
+         * @details With a source installed the budget is the resident memory
+         *          plus the free memory minus the minimum set with
+         *          SetMinimumFree. The budget thereby follows the device, and
+         *          other applications and untracked allocations make the
+         *          registry evict as well.
+         * @param   aSource [in] Free memory source or an empty function to
+         *          use the fallback budget
+         */
+        void SetFreeMemorySource(
+            FreeMemorySource aSource);
+
+        /**
+         * @brief   Set the device memory to keep free
+         * @param   aMinimumFreeBytes [in] Minimum free device memory in bytes,
+         *          64 MiB unless set otherwise
+         */
+        void SetMinimumFree(
+            std::size_t aMinimumFreeBytes) noexcept;
+
+        /**
+         * @brief   Limit the eviction work done at the end of a frame
+         * @details Each eviction may re-upload a texture, so shrinking many
+         *          resources at once stalls the frame. Resources beyond the
+         *          limit are shrunk at the end of the following frames.
+         * @param   aMaxEvictions [in] Maximum number of resources to shrink
+         *          per frame, 4 unless set otherwise
+         */
+        void SetMaxEvictionsPerFrame(
+            std::size_t aMaxEvictions) noexcept;
+
+        /**
+         * @brief   Limit the memory budget
+         * @details An explicit limit caps the budget whether or not a free
+         *          memory source is installed.
+         * @param   aBudgetBytes [in] Maximum budget in bytes or std::nullopt
+         *          to follow the device or the fallback budget again
+         */
+        void SetBudget(
+            std::optional<std::size_t> aBudgetBytes) noexcept;
+
+        /**
+         * @brief   Memory budget currently in effect in bytes
+         */
+        std::size_t Budget() const noexcept;
+
+        /**
+         * @brief   Register a resource
+         * @details Register a resource with its size and owner tag. Resources
+         *          registered with an eviction callback are streamable and
+         *          may be shrunk when the registry is over budget.
+         * @param   aType [in] Kind of the resource
+         * @param   aBytes [in] Size of the resource in bytes
+         * @param   aOwner [in] Tag identifying the owner for diagnostics
+         * @param   aEvict [in] Callback evicting part of the resource or an
+         *          empty function for resources that must stay resident
+         * @param   aRestore [in] Callback restoring an evicted resource
+         * @throw   Throws std::length_error in case all handles are in use.
+         * @return  Handle of the registered resource
+         */
+        ResourceId Register(
+            ResourceType aType,
+            std::size_t aBytes,
+            std::string aOwner,
+            EvictCallback aEvict = EvictCallback(),
+            RestoreCallback aRestore = RestoreCallback());
+
+        /**
+         * @brief   Remove a resource from the registry
+         * @param   aId [in] Handle of the resource, 0 is ignored
+         */
+        void Unregister(
+            ResourceId aId) noexcept;
+
+        /**
+         * @brief   Update the size of a resource
+         * @param   aId [in] Handle of the resource
+         * @param   aBytes [in] New size of the resource in bytes
+         */
+        void Resize(
+            ResourceId aId,
+            std::size_t aBytes) noexcept;
+
+        /**
+         * @brief   Mark a resource as used in the current frame
+         * @details Resources used in the current frame are never evicted at
+         *          the end of that frame.
+         * @param   aId [in] Handle of the resource
+         */
+        void Touch(
+            ResourceId aId) noexcept;
+
+        /**
+         * @brief   Finish the current frame
+         * @details Evict the least recently used streamable resources while
+         *          over budget, restore evicted resources when there is room
+         *          again, record the statistics of the frame and advance to
+         *          the next one.
+         */
+        void EndFrame();
+
+        /**
+         * @brief   Statistics recorded by the last call to EndFrame
+         */
+        const ResidencyStats &Stats() const noexcept;
+
+        /**
+         * @brief   Size of a resource in bytes
+         */
+        std::size_t Bytes(
+            ResourceId aId) const noexcept;
+
+        /**
+         * @brief   Owner tag of a resource
+         */
+        const std::string &Owner(
+            ResourceId aId) const noexcept;
+
+    private:
+        /**
+         * @brief   Bookkeeping of a registered resource
+         */
+        struct Entry
+        {
+            ResourceType mType;
+            std::size_t mBytes;
+            // Size of the resource when it was registered
+            std::size_t mFullBytes;
+            std::uint64_t mLastUsedFrame;
+            std::string mOwner;
+            EvictCallback mEvict;
+            RestoreCallback mRestore;
+            // Generation stored in the upper bits of the handle
+            std::uint32_t mGeneration;
+            bool mRegistered;
+        };
+
+        // Registered resources indexed by slot
+        std::vector<Entry> mEntries;
+        // Released slots available for reuse
+        std::vector<std::size_t> mFreeSlots;
+        // Budget in bytes used without a free memory source
+        std::size_t mFallbackBudget;
+        // Budget limit set explicitly by the user, if any
+        std::optional<std::size_t> mBudgetLimit;
+        // Budget in effect for the current frame in bytes
+        std::size_t mBudget;
+        // Sum of the sizes of all registered resources in bytes
+        std::size_t mResidentBytes;
+        // Number of the current frame
+        std::uint64_t mFrame;
+        // Query of the free device memory, may be empty
+        FreeMemorySource mFreeMemory;
+        // Device memory to keep free in bytes
+        std::size_t mMinimumFree;
+        // Maximum number of resources shrunk per frame
+        std::size_t mMaxEvictions;
+        // Statistics of the last finished frame
+        ResidencyStats mStats;
+
+        /**
+         * @brief   Look up the entry for a handle
+         * @return  Pointer to the entry or nullptr for invalid handles
+         */
+        Entry *Find(
+            ResourceId aId) noexcept;
+        const Entry *Find(
+            ResourceId aId) const noexcept;
+
+        /**
+         * @brief   Refresh the budget from the free device memory
+         * @details Shrink the budget below the resident memory by the amount
+         *          the free memory falls short of the minimum.
+         */
+        void UpdateBudget();
+
+        /**
+         * @brief   Evict least recently used resources until within budget
+         * @details Stops early once mMaxEvictions resources were shrunk.
+         * @return  Number of resources shrunk
+         */
+        std::size_t Evict();
+
+        /**
+         * @brief   Restore the smallest evicted resource in use that fits
+         * @return  Number of restored resources
+         */
+        std::size_t Restore();
+    };
+
+} // namespace Glance
+
+#endif // GLANCE_RESOURCE_REGISTRY_HPP
@@ -21,10 +21,14 @@
 #define GLANCE_SHADER_HPP
 
 #include <string>
+#include <string_view>
 #include <exception>
+#include <vector>
 
 #include <glad/glad.h>
 
+#include "vfs.hpp"
+
 namespace Glance
 {
 
@@ -43,6 +47,39 @@ namespace Glance
             const std::string &aVertexPath,
             const std::string &aFragmentPath);
 
+        /**
+         * @brief   Constructor
+         * @details The constructor reads the shader sources from an asset pack
+         *          and compiles the shader program from them. The sources are
+         *          handed to OpenGL directly from the mapped pack without
+         *          copying.
+         * @throw   Throws ShaderException in case of unrecoverable error.
+         * @param   aVfs [in] Asset pack containing the shader sources
+         * @param   aVertexPath [in] Path to the vertex shader source inside
+         *          the asset pack
+         * @param   aFragmentPath [in] Path to the fragment shader source inside
+         *          the asset pack
+         */
+        Shader(
+            const Vfs &aVfs,
+            const std::string &aVertexPath,
+            const std::string &aFragmentPath);
+
+        /**
+         * @brief   Create a shader program from source
+         * @details Compile the shader program from sources held in memory,
+         *          e.g. shaders built into Glance itself.
+         * @param   aVertexSource [in] Source of the vertex shader
+         * @param   aFragmentSource [in] Source of the fragment shader
+         * @param   aFeedbackVaryings [in] Outputs to capture interleaved with
+         *          transform feedback, if any
+         * @return  The compiled shader program
+         */
+        static Shader FromSource(
+            std::string_view aVertexSource,
+            std::string_view aFragmentSource,
+            const std::vector<const char *> &aFeedbackVaryings = {});
+
         /**
          * @brief   Use this shader program
          * @details Use the compiled shader program. This function is typically
@@ -97,10 +134,41 @@ namespace Glance
             float aValue2,
             float aValue3);
 
+        /**
+         * @brief   Set a 4x4 matrix uniform
+         * @details Set the mat4 uniform identified by the specified name.
+         * @param   aName [in] Name of the matrix uniform to set.
+         * @param   aValue [in] 16 floats in column-major order.
+         */
+        void SetMatrixUniform(
+            const std::string &aName,
+            const float *aValue);
+
     private:
         // ID of the compiled shader program
         GLuint mProgramId;
 
+        /**
+         * @brief   Constructor
+         * @details Construct an empty shader program, to be built by
+         *          FromSource.
+         */
+        Shader();
+
+        /**
+         * @brief   Build the shader program
+         * @details Compile both shader stages and link them into the shader
+         *          program.
+         * @param   aVertexSource [in] Source of the vertex shader
+         * @param   aFragmentSource [in] Source of the fragment shader
+         * @param   aFeedbackVaryings [in] Outputs to capture interleaved with
+         *          transform feedback, if any
+         */
+        void Build(
+            std::string_view aVertexSource,
+            std::string_view aFragmentSource,
+            const std::vector<const char *> &aFeedbackVaryings = {});
+
         /**
          * @brief   Check compilation status for a shader
          * @details Get the compilation result for a shader and print any error
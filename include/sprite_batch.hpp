@@ -0,0 +1,228 @@
+/**
+ * Copyright 2021 Christoph Groß
+ *
+ * This file is part of Glance.
+ *
+ * Glance is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Glance is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Glance.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef GLANCE_SPRITE_BATCH_HPP
+#define GLANCE_SPRITE_BATCH_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <glad/glad.h>
+
+#include "resource_registry.hpp"
+#include "shader.hpp"
+#include "texture.hpp"
+
+namespace Glance
+{
+
+    /**
+     * @brief   Axis-aligned rectangle
+     */
+    struct SpriteRect
+    {
+        float mX;
+        float mY;
+        float mWidth;
+        float mHeight;
+    };
+
+    /**
+     * @brief   Order in which a SpriteBatch submits its sprites
+     */
+    enum class SpriteSortMode
+    {
+        // Sort by texture to minimise the number of draw calls. Sprites
+        // sharing a texture keep their relative order.
+        Texture,
+        // Keep the order of submission, e.g. for overlapping translucent
+        // sprites. Consecutive sprites sharing a texture are still batched.
+        Submission
+    };
+
+    /**
+     * @brief   Pack a colour into the format used by SpriteBatch
+     * @param   aRed [in] Red channel
+     * @param   aGreen [in] Green channel
+     * @param   aBlue [in] Blue channel
+     * @param   aAlpha [in] Alpha channel
+     * @return  Colour with the channels stored in RGBA byte order
+     */
+    constexpr std::uint32_t PackColor(
+        std::uint8_t aRed,
+        std::uint8_t aGreen,
+        std::uint8_t aBlue,
+        std::uint8_t aAlpha = 255) noexcept
+    {
+        return static_cast<std::uint32_t>(aRed) |
+               static_cast<std::uint32_t>(aGreen) << 8 |
+               static_cast<std::uint32_t>(aBlue) << 16 |
+               static_cast<std::uint32_t>(aAlpha) << 24;
+    }
+
+    class SpriteBatch
+    {
+    public:
+        /**
+         * @brief   Constructor
+         * @details Create the shader program, the streaming vertex buffer and
+         *          the shared static index buffer. Requires a current OpenGL
+         *          context.
+         */
+        SpriteBatch();
+
+        /**
+         * @brief   Destructor
+         * @details Delete all OpenGL objects of the batch. The OpenGL context
+         *          the batch was created in has to be current.
+         */
+        ~SpriteBatch();
+
+        SpriteBatch(const SpriteBatch &) = delete;
+        SpriteBatch &operator=(const SpriteBatch &) = delete;
+
+        /**
+         * @brief   Start a new batch
+         * @details Sprites are positioned in pixels with the origin in the
+         *          top left corner of the viewport.
+         * @param   aViewportWidth [in] Width of the viewport in pixels
+         * @param   aViewportHeight [in] Height of the viewport in pixels
+         * @param   aSortMode [in] Order in which to submit the sprites
+         */
+        void Begin(
+            int aViewportWidth,
+            int aViewportHeight,
+            SpriteSortMode aSortMode = SpriteSortMode::Texture);
+
+        /**
+         * @brief   Queue a sprite
+         * @details Queue a textured quad. Nothing is drawn before End.
+         * @param   aTexture [in] ID of the 2D texture to sample
+         * @param   aDestination [in] Rectangle covered on screen in pixels
+         * @param   aSource [in] Rectangle of the texture to sample in
+         *          normalized texture coordinates
+         * @param   aColor [in] Colour the texture is multiplied with, see
+         *          PackColor
+         */
+        void Draw(
+            GLuint aTexture,
+            const SpriteRect &aDestination,
+            const SpriteRect &aSource = {0.f, 0.f, 1.f, 1.f},
+            std::uint32_t aColor = PackColor(255, 255, 255));
+
+        /**
+         * @brief   Queue a sprite
+         * @details Queue a quad textured with a Glance texture and mark the
+         *          texture as used in the current frame.
+         * @param   aTexture [in] Texture to sample
+         * @param   aDestination [in] Rectangle covered on screen in pixels
+         * @param   aSource [in] Rectangle of the texture to sample in
+         *          normalized texture coordinates
+         * @param   aColor [in] Colour the texture is multiplied with, see
+         *          PackColor
+         */
+        void Draw(
+            const Texture &aTexture,
+            const SpriteRect &aDestination,
+            const SpriteRect &aSource = {0.f, 0.f, 1.f, 1.f},
+            std::uint32_t aColor = PackColor(255, 255, 255));
+
+        /**
+         * @brief   Draw all queued sprites
+         * @details Upload the queued sprites into the streaming vertex buffer
+         *          and draw them with as few draw calls as possible. Blending
+         *          is enabled and depth testing disabled while drawing; both
+         *          are restored afterwards.
+         */
+        void End();
+
+        /**
+         * @brief   Number of sprites drawn by the last call to End
+         */
+        std::size_t SpriteCount() const noexcept;
+
+        /**
+         * @brief   Number of draw calls issued by the last call to End
+         */
+        std::size_t DrawCallCount() const noexcept;
+
+    private:
+        /**
+         * @brief   A queued sprite
+         */
+        struct Sprite
+        {
+            GLuint mTexture;
+            std::uint32_t mColor;
+            SpriteRect mDestination;
+            SpriteRect mSource;
+        };
+
+        /**
+         * @brief   Layout of a single vertex in the streaming vertex buffer
+         */
+        struct Vertex
+        {
+            float mX;
+            float mY;
+            float mU;
+            float mV;
+            std::uint32_t mColor;
+        };
+
+        // Most quads a single draw call can address with 16 bit indices
+        static constexpr std::size_t MaxQuadsPerDraw = 65536 / 4;
+        // Quads the streaming vertex buffer holds before it is orphaned
+        static constexpr std::size_t BufferQuads = 4 * MaxQuadsPerDraw;
+
+        // Shader program drawing the sprites
+        Shader mShader;
+        // ID of the vertex array object
+        GLuint mVertexArrayObject;
+        // ID of the streaming vertex buffer
+        GLuint mVertexBufferObject;
+        // ID of the static index buffer
+        GLuint mElementBufferObject;
+        // Handle of the vertex buffer in the default resource registry
+        ResourceId mVertexBufferResource;
+        // Handle of the index buffer in the default resource registry
+        ResourceId mElementBufferResource;
+        // Next free quad in the streaming vertex buffer
+        std::size_t mBufferQuad;
+        // Width of the viewport in pixels
+        int mViewportWidth;
+        // Height of the viewport in pixels
+        int mViewportHeight;
+        // Order in which to submit the sprites
+        SpriteSortMode mSortMode;
+        // Sprites queued since Begin
+        std::vector<Sprite> mSprites;
+        // Sort keys of the queued sprites, kept to avoid reallocation
+        std::vector<std::uint64_t> mKeys;
+        // Number of sprites drawn by the last call to End
+        std::size_t mSpriteCount;
+        // Number of draw calls issued by the last call to End
+        std::size_t mDrawCallCount;
+    };
+
+} // namespace Glance
+
+#endif // GLANCE_SPRITE_BATCH_HPP
@@ -0,0 +1,203 @@
+/**
+ * Copyright 2021 Christoph Groß
+ *
+ * This file is part of Glance.
+ *
+ * Glance is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Glance is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Glance.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef GLANCE_TEXTURE_HPP
+#define GLANCE_TEXTURE_HPP
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <exception>
+
+#include <glad/glad.h>
+
+#include "resource_registry.hpp"
+#include "vfs.hpp"
+
+namespace Glance
+{
+
+    class Texture
+    {
+    public:
+        /**
+         * @brief   Constructor
+         * @details The constructor decodes an image from an asset pack and
+         *          uploads it as a mipmapped 2D texture. The image is decoded
+         *          directly from the mapped pack without an intermediate
+         *          copy of the encoded file. The texture is registered with the
+         *          default ResourceRegistry as a streamable resource: its top
+         *          mip levels may be dropped while unused and over budget, and
+         *          are decoded from the asset pack again once needed.
+         * @note    The asset pack has to outlive the texture.
+         * @throw   Throws TextureException in case of unrecoverable error.
+         * @param   aVfs [in] Asset pack containing the image
+         * @param   aPath [in] Path to the image inside the asset pack
+         */
+        Texture(
+            const Vfs &aVfs,
+            const std::string &aPath);
+
+        /**
+         * @brief   Destructor
+         * @details Delete the texture object. The OpenGL context the texture
+         *          was created in has to be current.
+         */
+        ~Texture();
+
+        Texture(const Texture &) = delete;
+        Texture &operator=(const Texture &) = delete;
+
+        /**
+         * @brief   Bind this texture
+         * @details Bind the texture to the GL_TEXTURE_2D target of the
+         *          currently active texture unit and mark it as used in the
+         *          current frame.
+         */
+        void Bind() const;
+
+        /**
+         * @brief   Mark this texture as used in the current frame
+         * @details Keeps the texture resident when it is sampled without
+         *          being bound through Bind, e.g. by a SpriteBatch.
+         */
+        void MarkUsed() const noexcept;
+
+        /**
+         * @brief   ID of the texture object
+         */
+        GLuint Id() const noexcept;
+
+        /**
+         * @brief   Width of the full resolution image in pixels
+         */
+        int Width() const noexcept;
+
+        /**
+         * @brief   Height of the full resolution image in pixels
+         */
+        int Height() const noexcept;
+
+        /**
+         * @brief   Number of mip levels of the full resolution image
+         */
+        int LevelCount() const noexcept;
+
+        /**
+         * @brief   Memory currently used by the texture in bytes
+         * @details Counts the bytes of the sized internal format, i.e. one
+         *          byte per channel and four bytes per texel for RGB images.
+         */
+        std::size_t Bytes() const noexcept;
+
+    private:
+        // Asset pack the image is decoded from
+        const Vfs &mVfs;
+        // Path of the image inside the asset pack
+        std::string mPath;
+        // ID of the texture object
+        GLuint mTextureId;
+        // Width of the full resolution image in pixels
+        int mWidth;
+        // Height of the full resolution image in pixels
+        int mHeight;
+        // Number of channels per pixel
+        int mChannels;
+        // Number of top mip levels dropped to stay within budget
+        int mDroppedLevels;
+        // Handle of the texture in the default resource registry
+        ResourceId mResourceId;
+
+        /**
+         * @brief   Upload the image
+         * @details Decode the image from the asset pack, downsample it on the
+         *          CPU by the given number of levels and upload it with a
+         *          complete mip chain to the bound texture. Grey images are
+         *          swizzled to sample as grey in all colour channels.
+         * @throw   Throws TextureException in case of unrecoverable error.
+         * @param   aDroppedLevels [in] Number of top mip levels to leave out
+         */
+        void Upload(
+            int aDroppedLevels);
+
+        /**
+         * @brief   Drop top mip levels
+         * @details Drop as many levels as needed to free the given memory in
+         *          one step, keeping at least the 1x1 level. The image is
+         *          decoded from the asset pack once and halved once per
+         *          dropped level, so no texture data is read back from the
+         *          GPU.
+         * @param   aBytesToFree [in] Memory to free in bytes
+         * @return  Memory used by the texture afterwards in bytes
+         */
+        std::size_t DropLevels(
+            std::size_t aBytesToFree);
+
+        /**
+         * @brief   Memory used with the given number of dropped levels
+         * @param   aDroppedLevels [in] Number of top mip levels left out
+         */
+        std::size_t LevelBytes(
+            int aDroppedLevels) const noexcept;
+
+        /**
+         * @brief   Halve an image with a 2x2 box filter
+         * @param   aImage [in] Tightly packed image with mChannels channels
+         * @param   aWidth [in] Width of the image in pixels
+         * @param   aHeight [in] Height of the image in pixels
+         * @return  Image of size max(1, aWidth / 2) x max(1, aHeight / 2)
+         */
+        std::vector<unsigned char> HalveImage(
+            const std::vector<unsigned char> &aImage,
+            int aWidth,
+            int aHeight) const;
+
+        /**
+         * @brief   Pixel format matching the number of channels
+         */
+        GLenum Format() const noexcept;
+    };
+
+    class TextureException : public std::exception
+    {
+    public:
+        /**
+         * @brief   Constructor
+         * @details Construct a TextureException object with information on the
+         *          error that occured.
+         * @param   aErrorMsg [in] Descriptive error string explaining what went
+         *          wrong
+         */
+        TextureException(
+            std::string aErrorMsg) noexcept;
+
+        /**
+         * @brief   Description of the exception
+         */
+        const char *what() const noexcept override;
+
+    private:
+        // A descriptive error message
+        std::string mErrorMsg;
+    };
+
+} // namespace Glance
+
+#endif // GLANCE_TEXTURE_HPP
@@ -0,0 +1,228 @@
+/**
+ * Copyright 2021 Christoph Groß
+ *
+ * This file is part of Glance.
+ *
+ * Glance is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Glance is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Glance.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef GLANCE_VFS_HPP
+#define GLANCE_VFS_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <string_view>
+#include <exception>
+
+namespace Glance
+{
+
+    /**
+     * @brief   Header at the start of every asset pack
+     * @details An asset pack consists of this header, directly followed by
+     *          mEntryCount PackEntry records sorted by hash, a blob holding
+     *          the entry names and finally the entry data. All offsets are
+     *          absolute offsets from the start of the pack file.
+     */
+    struct PackHeader
+    {
+        char mMagic[4];
+        std::uint32_t mVersion;
+        std::uint32_t mEntryCount;
+        std::uint32_t mReserved;
+        std::uint64_t mNamesOffset;
+        std::uint64_t mDataOffset;
+    };
+
+    /**
+     * @brief   Index record of a single file in an asset pack
+     */
+    struct PackEntry
+    {
+        std::uint64_t mHash;
+        std::uint64_t mDataOffset;
+        std::uint64_t mDataSize;
+        std::uint32_t mNameOffset;
+        std::uint32_t mNameLength;
+    };
+
+    /// Magic bytes identifying an asset pack
+    constexpr char PackMagic[4] = {'G', 'L', 'P', 'K'};
+    /// Version of the asset pack layout written by PackWriter
+    constexpr std::uint32_t PackVersion = 1;
+    /// Alignment of every data blob inside an asset pack
+    constexpr std::uint64_t PackDataAlignment = 16;
+
+    /**
+     * @brief   Hash a path for lookup in an asset pack
+     * @details Computes the 64 bit FNV-1a hash of the given path. Paths are
+     *          hashed verbatim, so they have to use forward slashes and be
+     *          relative to the pack root.
+     * @param   aPath [in] Path to hash
+     * @return  Hash value of the path
+     */
+    std::uint64_t PackHash(
+        std::string_view aPath) noexcept;
+
+    class PackWriter
+    {
+    public:
+        /**
+         * @brief   Add a file from memory
+         * @details Add a file with the given contents to the pack. Adding a
+         *          path twice replaces the previous contents.
+         * @param   aPath [in] Path of the file inside the pack
+         * @param   aData [in] Contents of the file
+         */
+        void Add(
+            const std::string &aPath,
+            std::string aData);
+
+        /**
+         * @brief   Add a file from disk
+         * @details Read the file at aSourcePath and add it to the pack under
+         *          the name aPath.
+         * @throw   Throws VfsException in case the file cannot be read.
+         * @param   aPath [in] Path of the file inside the pack
+         * @param   aSourcePath [in] Path of the file on disk
+         */
+        void AddFile(
+            const std::string &aPath,
+            const std::string &aSourcePath);
+
+        /**
+         * @brief   Write the asset pack
+         * @details Write all added files into a single asset pack at the
+         *          given location.
+         * @throw   Throws VfsException in case the pack cannot be written.
+         * @param   aPackPath [in] Path of the asset pack to write
+         */
+        void Write(
+            const std::string &aPackPath) const;
+
+    private:
+        // Contents of all added files, keyed by their path inside the pack
+        std::map<std::string, std::string> mFiles;
+    };
+
+    class Vfs
+    {
+    public:
+        /**
+         * @brief   Constructor
+         * @details Map the asset pack at the given location into memory and
+         *          validate its index. File contents are not read until they
+         *          are accessed.
+         * @throw   Throws VfsException in case the pack cannot be mapped or
+         *          is malformed.
+         * @param   aPackPath [in] Path of the asset pack on disk
+         */
+        explicit Vfs(
+            const std::string &aPackPath);
+
+        /**
+         * @brief   Destructor
+         * @details Unmap the asset pack. All views previously returned by
+         *          Read become invalid.
+         */
+        ~Vfs();
+
+        Vfs(const Vfs &) = delete;
+        Vfs &operator=(const Vfs &) = delete;
+
+        /**
+         * @brief   Check whether a file exists
+         * @param   aPath [in] Path of the file inside the pack
+         * @return  true in case the pack contains the file and
+         *          false otherwise.
+         */
+        bool Contains(
+            std::string_view aPath) const noexcept;
+
+        /**
+         * @brief   Read a file
+         * @details Look up a file in the pack index and return a view of its
+         *          contents. The view points directly into the mapped pack
+         *          and stays valid for the lifetime of this object.
+         * @note    The returned view is not null-terminated.
+         * @throw   Throws VfsException in case the file does not exist.
+         * @param   aPath [in] Path of the file inside the pack
+         * @return  View of the file contents
+         */
+        std::string_view Read(
+            std::string_view aPath) const;
+
+        /**
+         * @brief   Number of files in the pack
+         */
+        std::size_t FileCount() const noexcept;
+
+        /**
+         * @brief   Directory of the running executable
+         * @details Determine the directory containing the running executable
+         *          so asset packs can be located independent of the current
+         *          working directory.
+         * @throw   Throws VfsException in case the directory cannot be
+         *          determined.
+         * @return  Directory of the executable including a trailing slash
+         */
+        static std::string ExecutableDirectory();
+
+    private:
+        // Start of the mapped asset pack
+        const char *mData;
+        // Size of the mapped asset pack in bytes
+        std::size_t mSize;
+        // Index of the asset pack, sorted by hash
+        const PackEntry *mEntries;
+        // Number of entries in the index
+        std::uint32_t mEntryCount;
+
+        /**
+         * @brief   Find the index entry for a path
+         * @param   aPath [in] Path of the file inside the pack
+         * @return  Pointer to the matching entry or nullptr if there is none
+         */
+        const PackEntry *Find(
+            std::string_view aPath) const noexcept;
+    };
+
+    class VfsException : public std::exception
+    {
+    public:
+        /**
+         * @brief   Constructor
+         * @details Construct a VfsException object with information on the
+         *          error that occured.
+         * @param   aErrorMsg [in] Descriptive error string explaining what went
+         *          wrong
+         */
+        VfsException(
+            std::string aErrorMsg) noexcept;
+
+        /**
+         * @brief   Description of the exception
+         */
+        const char *what() const noexcept override;
+
+    private:
+        // A descriptive error message
+        std::string mErrorMsg;
+    };
+
+} // namespace Glance
+
+#endif // GLANCE_VFS_HPP
@@ -0,0 +1,281 @@
+/**
+ * Copyright 2021 Christoph Groß
+ *
+ * This file is part of Glance.
+ *
+ * Glance is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Glance is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Glance.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+
+#define STB_TRUETYPE_IMPLEMENTATION
+#include <stb_truetype.h>
+
+#include "font.hpp"
+
+namespace
+{
+
+    /**
+     * @brief   Read a font file from an asset pack
+     * @throw   Throws FontException in case the file does not exist.
+     */
+    std::string_view ReadFont(
+        const Glance::Vfs &aVfs,
+        const std::string &aPath)
+    {
+        try
+        {
+            return aVfs.Read(aPath);
+        }
+        catch (const Glance::VfsException &e)
+        {
+            std::string errorMsg = "Exception while reading font: ";
+            errorMsg += e.what();
+            throw Glance::FontException(errorMsg);
+        }
+    }
+
+} // namespace
+
+namespace Glance
+{
+
+    FontAtlas::FontAtlas(
+        std::string_view aData,
+        const std::string &aName,
+        float aPixelHeight)
+        : mGlyphs(CharacterCount),
+          mWidth(256),
+          mHeight(256),
+          mLineHeight(0.f)
+    {
+        // stb_truetype trusts its input, so at least make sure this is a
+        // font before handing it over
+        const unsigned char *font = reinterpret_cast<const unsigned char *>(
+            aData.data());
+        const int offset = aData.size() < 12
+                               ? -1
+                               : stbtt_GetFontOffsetForIndex(font, 0);
+        stbtt_fontinfo info;
+        if (offset < 0 || !stbtt_InitFont(&info, font, offset))
+        {
+            throw FontException(aName + " is not a TrueType font");
+        }
+
+        int ascent, descent, lineGap;
+        stbtt_GetFontVMetrics(&info, &ascent, &descent, &lineGap);
+        mLineHeight = (ascent - descent + lineGap) *
+                      stbtt_ScaleForPixelHeight(&info, aPixelHeight);
+
+        // Grow the atlas until all glyphs fit
+        std::vector<stbtt_bakedchar> baked(CharacterCount);
+        for (;;)
+        {
+            mBitmap.assign(static_cast<std::size_t>(mWidth) * mHeight, 0);
+            if (0 < stbtt_BakeFontBitmap(font, offset, aPixelHeight,
+                                         mBitmap.data(), mWidth, mHeight,
+                                         FirstCharacter, CharacterCount,
+                                         baked.data()))
+            {
+                break;
+            }
+            if (4096 <= mHeight)
+            {
+                throw FontException("Glyphs of " + aName +
+                                    " do not fit into the atlas");
+            }
+            if (mWidth == mHeight)
+            {
+                mWidth *= 2;
+            }
+            else
+            {
+                mHeight *= 2;
+            }
+        }
+        for (int i = 0; i < CharacterCount; ++i)
+        {
+            mGlyphs[i] = {baked[i].x0, baked[i].y0, baked[i].x1, baked[i].y1,
+                          baked[i].xoff, baked[i].yoff, baked[i].xadvance};
+        }
+    }
+
+    const FontAtlas::Glyph *FontAtlas::Find(
+        char aCharacter) const noexcept
+    {
+        const int index = static_cast<unsigned char>(aCharacter) -
+                          FirstCharacter;
+        if (index < 0 || index >= CharacterCount)
+        {
+            return nullptr;
+        }
+        return &mGlyphs[index];
+    }
+
+    float FontAtlas::Measure(
+        std::string_view aText) const noexcept
+    {
+        float width = 0.f;
+        float lineWidth = 0.f;
+        for (char c : aText)
+        {
+            const Glyph *glyph = Find(c);
+            if ('\n' == c)
+            {
+                lineWidth = 0.f;
+            }
+            else if (glyph)
+            {
+                lineWidth += glyph->mAdvance;
+                width = std::max(width, lineWidth);
+            }
+        }
+        return width;
+    }
+
+    float FontAtlas::LineHeight() const noexcept
+    {
+        return mLineHeight;
+    }
+
+    int FontAtlas::Width() const noexcept
+    {
+        return mWidth;
+    }
+
+    int FontAtlas::Height() const noexcept
+    {
+        return mHeight;
+    }
+
+    const std::vector<unsigned char> &FontAtlas::Bitmap() const noexcept
+    {
+        return mBitmap;
+    }
+
+    Font::Font(
+        const Vfs &aVfs,
+        const std::string &aPath,
+        float aPixelHeight)
+        : mAtlas(ReadFont(aVfs, aPath), aPath, aPixelHeight),
+          mTextureId(0),
+          mResourceId(0)
+    {
+        // Single channel atlas, swizzled so it samples as white with the
+        // coverage in alpha and works with the regular sprite shader
+        const GLint swizzle[] = {GL_ONE, GL_ONE, GL_ONE, GL_RED};
+        glGenTextures(1, &mTextureId);
+        glBindTexture(GL_TEXTURE_2D, mTextureId);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+        glTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_RGBA, swizzle);
+        GLint unpackAlignment;
+        glGetIntegerv(GL_UNPACK_ALIGNMENT, &unpackAlignment);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glTexImage2D(/* target         = */ GL_TEXTURE_2D,
+                     /* level          = */ 0,
+                     /* internalFormat = */ GL_R8,
+                     /* width          = */ mAtlas.Width(),
+                     /* height         = */ mAtlas.Height(),
+                     /* border         = */ 0,
+                     /* format         = */ GL_RED,
+                     /* type           = */ GL_UNSIGNED_BYTE,
+                     /* data           = */ mAtlas.Bitmap().data());
+        glPixelStorei(GL_UNPACK_ALIGNMENT, unpackAlignment);
+
+        mResourceId = ResourceRegistry::Default().Register(
+            ResourceType::Texture, mAtlas.Bitmap().size(), "font:" + aPath);
+    }
+
+    Font::~Font()
+    {
+        ResourceRegistry::Default().Unregister(mResourceId);
+        glDeleteTextures(1, &mTextureId);
+    }
+
+    void Font::Draw(
+        SpriteBatch &aBatch,
+        std::string_view aText,
+        float aX,
+        float aY,
+        std::uint32_t aColor) const
+    {
+        const float atlasWidth = static_cast<float>(mAtlas.Width());
+        const float atlasHeight = static_cast<float>(mAtlas.Height());
+        float x = aX;
+        float y = aY;
+
+        ResourceRegistry::Default().Touch(mResourceId);
+        for (char c : aText)
+        {
+            if ('\n' == c)
+            {
+                x = aX;
+                y += mAtlas.LineHeight();
+                continue;
+            }
+            const FontAtlas::Glyph *glyph = mAtlas.Find(c);
+            if (!glyph)
+            {
+                continue;
+            }
+
+            // Same placement as stbtt_GetBakedQuad, snapped to whole pixels
+            const float width = static_cast<float>(glyph->mX1 - glyph->mX0);
+            const float height = static_cast<float>(glyph->mY1 - glyph->mY0);
+            if (width > 0.f && height > 0.f)
+            {
+                aBatch.Draw(mTextureId,
+                            {std::floor(x + glyph->mOffsetX + .5f),
+                             std::floor(y + glyph->mOffsetY + .5f),
+                             width, height},
+                            {glyph->mX0 / atlasWidth, glyph->mY0 / atlasHeight,
+                             width / atlasWidth, height / atlasHeight},
+                            aColor);
+            }
+            x += glyph->mAdvance;
+        }
+    }
+
+    float Font::Measure(
+        std::string_view aText) const noexcept
+    {
+        return mAtlas.Measure(aText);
+    }
+
+    float Font::LineHeight() const noexcept
+    {
+        return mAtlas.LineHeight();
+    }
+
+    FontException::FontException(
+        std::string aErrorMsg) noexcept
+        : mErrorMsg(aErrorMsg)
+    {
+    }
+
+    const char *FontException::what() const noexcept
+    {
+        return mErrorMsg.c_str();
+    }
+
+} // namespace Glance
@@ -0,0 +1,697 @@
+/**
+ * Copyright 2021 Christoph Groß
+ *
+ * This file is part of Glance.
+ *
+ * Glance is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Glance is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Glance.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#include "occlusion_culler.hpp"
+
+namespace
+{
+
+    const char *const FullscreenVertexShader = R"(#version 400 core
+
+void main()
+{
+    // A single triangle covering the whole viewport
+    vec2 position = vec2( ( gl_VertexID << 1 ) & 2, gl_VertexID & 2 );
+    gl_Position = vec4( position * 2.0 - 1.0, 0.0, 1.0 );
+}
+)";
+
+    const char *const CopyFragmentShader = R"(#version 400 core
+
+uniform sampler2D depthTexture;
+
+out float farthest;
+
+void main()
+{
+    farthest = texelFetch( depthTexture, ivec2( gl_FragCoord.xy ), 0 ).r;
+}
+)";
+
+    const char *const ReduceFragmentShader = R"(#version 400 core
+
+// Only the previous level is accessible, it is the base level of the texture
+uniform sampler2D previousLevel;
+
+out float farthest;
+
+float Fetch( ivec2 aCoord, ivec2 aLast )
+{
+    return texelFetch( previousLevel, min( aCoord, aLast ), 0 ).r;
+}
+
+void main()
+{
+    ivec2 size = textureSize( previousLevel, 0 );
+    ivec2 last = size - 1;
+    ivec2 coord = ivec2( gl_FragCoord.xy ) * 2;
+
+    float depth = max( max( Fetch( coord, last ),
+                            Fetch( coord + ivec2( 1, 0 ), last ) ),
+                       max( Fetch( coord + ivec2( 0, 1 ), last ),
+                            Fetch( coord + ivec2( 1, 1 ), last ) ) );
+
+    // With an odd size the last texel in a row or column has no partner.
+    // Fold it into the last texel of the next level, so no depth is lost.
+    bool extraColumn = 0 != ( size.x & 1 ) && coord.x + 2 == last.x;
+    bool extraRow = 0 != ( size.y & 1 ) && coord.y + 2 == last.y;
+    if ( extraColumn )
+    {
+        depth = max( depth, max( Fetch( coord + ivec2( 2, 0 ), last ),
+                                 Fetch( coord + ivec2( 2, 1 ), last ) ) );
+    }
+    if ( extraRow )
+    {
+        depth = max( depth, max( Fetch( coord + ivec2( 0, 2 ), last ),
+                                 Fetch( coord + ivec2( 1, 2 ), last ) ) );
+    }
+    if ( extraColumn && extraRow )
+    {
+        depth = max( depth, Fetch( coord + ivec2( 2, 2 ), last ) );
+    }
+
+    farthest = depth;
+}
+)";
+
+    const char *const CullVertexShader = R"(#version 400 core
+
+layout ( location = 0 ) in vec3 aBoundsMin;
+layout ( location = 1 ) in vec3 aBoundsMax;
+layout ( location = 2 ) in uvec2 aDraw;
+layout ( location = 3 ) in int aBaseVertex;
+
+uniform mat4 viewProjection;
+uniform mat4 occlusionViewProjection;
+uniform sampler2D pyramid;
+uniform int pyramidLevels;
+
+// Captured with transform feedback as a DrawElementsIndirectCommand
+flat out uint commandCount;
+flat out uint commandInstanceCount;
+flat out uint commandFirstIndex;
+flat out int commandBaseVertex;
+flat out uint commandBaseInstance;
+
+vec3 Corner( int aIndex )
+{
+    return mix( aBoundsMin, aBoundsMax,
+                vec3( aIndex & 1, ( aIndex >> 1 ) & 1, ( aIndex >> 2 ) & 1 ) );
+}
+
+bool InsideFrustum()
+{
+    // The box is outside if all of its corners are outside the same plane
+    ivec3 below = ivec3( 0 );
+    ivec3 above = ivec3( 0 );
+    for ( int i = 0; i < 8; ++i )
+    {
+        vec4 clip = viewProjection * vec4( Corner( i ), 1.0 );
+        below += ivec3( lessThan( clip.xyz, vec3( -clip.w ) ) );
+        above += ivec3( greaterThan( clip.xyz, vec3( clip.w ) ) );
+    }
+    return !any( equal( below, ivec3( 8 ) ) ) &&
+           !any( equal( above, ivec3( 8 ) ) );
+}
+
+bool PassesDepthTest()
+{
+    if ( 0 == pyramidLevels )
+    {
+        return true;
+    }
+
+    vec3 ndcMin = vec3( 1.0 );
+    vec3 ndcMax = vec3( -1.0 );
+    for ( int i = 0; i < 8; ++i )
+    {
+        vec4 clip = occlusionViewProjection * vec4( Corner( i ), 1.0 );
+        if ( clip.w <= 0.0 )
+        {
+            // Crosses the near plane, the projection cannot bound it
+            return true;
+        }
+        vec3 ndc = clip.xyz / clip.w;
+        ndcMin = min( ndcMin, ndc );
+        ndcMax = max( ndcMax, ndc );
+    }
+    if ( any( greaterThan( ndcMin.xy, vec2( 1.0 ) ) ) ||
+         any( lessThan( ndcMax.xy, vec2( -1.0 ) ) ) )
+    {
+        // Was not on screen when the pyramid was built
+        return true;
+    }
+
+    vec2 uvMin = clamp( ndcMin.xy * 0.5 + 0.5, 0.0, 1.0 );
+    vec2 uvMax = clamp( ndcMax.xy * 0.5 + 0.5, 0.0, 1.0 );
+    float nearest = ndcMin.z * 0.5 + 0.5;
+
+    // CPU reference: detail::SelectHiZTexels in occlusion_culler.hpp, keep
+    // the two in sync. Covered texels are found in level 0 and shifted down,
+    // scaling the coordinates by a level size that was rounded down would
+    // miss texels at the far edge.
+    ivec2 baseSize = textureSize( pyramid, 0 );
+    ivec2 baseLow = clamp( ivec2( floor( uvMin * vec2( baseSize ) ) ),
+                           ivec2( 0 ), baseSize - 1 );
+    ivec2 baseHigh = clamp( ivec2( floor( uvMax * vec2( baseSize ) ) ),
+                            ivec2( 0 ), baseSize - 1 );
+
+    // Pick the level where the box covers at most 2x2 texels
+    ivec2 extent = baseHigh - baseLow;
+    int level = min( findMSB( max( extent.x, extent.y ) ) + 1,
+                     pyramidLevels - 1 );
+    ivec2 last = textureSize( pyramid, level ) - 1;
+    ivec2 low = min( baseLow >> level, last );
+    ivec2 high = min( baseHigh >> level, last );
+
+    float farthest = max(
+        max( texelFetch( pyramid, low, level ).r,
+             texelFetch( pyramid, ivec2( high.x, low.y ), level ).r ),
+        max( texelFetch( pyramid, ivec2( low.x, high.y ), level ).r,
+             texelFetch( pyramid, high, level ).r ) );
+    return nearest <= farthest;
+}
+
+void main()
+{
+    commandCount = aDraw.x;
+    commandInstanceCount = InsideFrustum() && PassesDepthTest() ? 1u : 0u;
+    commandFirstIndex = aDraw.y;
+    commandBaseVertex = aBaseVertex;
+    commandBaseInstance = 0u;
+}
+)";
+
+    const char *const CullFragmentShader = R"(#version 400 core
+
+out vec4 fragmentColor;
+
+void main()
+{
+    // Never invoked, culling runs with the rasterizer disabled
+    fragmentColor = vec4( 0.0 );
+}
+)";
+
+} // namespace
+
+namespace Glance
+{
+
+    namespace detail
+    {
+
+        int HiZLevelSize(
+            int aBaseSize,
+            int aLevel) noexcept
+        {
+            return std::max(1, aBaseSize >> aLevel);
+        }
+
+        HiZTexelRange SelectHiZTexels(
+            float aMinU,
+            float aMinV,
+            float aMaxU,
+            float aMaxV,
+            int aWidth,
+            int aHeight,
+            int aLevels) noexcept
+        {
+            auto baseTexel = [](float aCoord, int aSize)
+            {
+                const float texel = std::floor(std::clamp(aCoord, 0.f, 1.f) *
+                                               static_cast<float>(aSize));
+                return std::min(static_cast<int>(texel), aSize - 1);
+            };
+            const int minX = baseTexel(aMinU, aWidth);
+            const int minY = baseTexel(aMinV, aHeight);
+            const int maxX = baseTexel(aMaxU, aWidth);
+            const int maxY = baseTexel(aMaxV, aHeight);
+
+            // Two texels a and b are at most one texel apart in level l once
+            // b - a < 2^l, i.e. l is the bit length of b - a
+            int level = 0;
+            for (int extent = std::max(maxX - minX, maxY - minY); extent > 0;
+                 extent >>= 1)
+            {
+                ++level;
+            }
+            level = std::min(level, std::max(0, aLevels - 1));
+
+            const int lastX = HiZLevelSize(aWidth, level) - 1;
+            const int lastY = HiZLevelSize(aHeight, level) - 1;
+            return {level,
+                    std::min(minX >> level, lastX), std::min(minY >> level, lastY),
+                    std::min(maxX >> level, lastX), std::min(maxY >> level, lastY)};
+        }
+
+    } // namespace detail
+
+    OcclusionCuller::OcclusionCuller(GLADloadproc aLoader)
+        : mCopyShader(Shader::FromSource(FullscreenVertexShader,
+                                         CopyFragmentShader)),
+          mReduceShader(Shader::FromSource(FullscreenVertexShader,
+                                           ReduceFragmentShader)),
+          mCullShader(Shader::FromSource(CullVertexShader, CullFragmentShader,
+                                         {"commandCount",
+                                          "commandInstanceCount",
+                                          "commandFirstIndex",
+                                          "commandBaseVertex",
+                                          "commandBaseInstance"})),
+          mEmptyVertexArrayObject(0),
+          mObjectVertexArrayObject(0),
+          mObjectBuffer(0),
+          mCommandBuffer(0),
+          mFramebuffer(0),
+          mPyramidTexture(0),
+          mPyramidWidth(0),
+          mPyramidHeight(0),
+          mPyramidLevels(0),
+          mPyramidViewProjection(),
+          mObjectCount(0),
+          mFrame(0),
+          mReadbacks(),
+          mStats(),
+          mMultiDrawElementsIndirect(nullptr)
+    {
+        glGenVertexArrays(1, &mEmptyVertexArrayObject);
+        glGenVertexArrays(1, &mObjectVertexArrayObject);
+        glGenBuffers(1, &mObjectBuffer);
+        glGenBuffers(1, &mCommandBuffer);
+        glGenFramebuffers(1, &mFramebuffer);
+        glGenTextures(1, &mPyramidTexture);
+        for (Readback &readback : mReadbacks)
+        {
+            glGenBuffers(1, &readback.mBuffer);
+        }
+
+        glBindVertexArray(mObjectVertexArrayObject);
+        glBindBuffer(GL_ARRAY_BUFFER, mObjectBuffer);
+        glVertexAttribPointer(/* index         = */ 0,
+                              /* size          = */ 3,
+                              /* type          = */ GL_FLOAT,
+                              /* normalized    = */ GL_FALSE,
+                              /* stride        = */ sizeof(OcclusionObject),
+                              /* offset        = */ (const void *)offsetof(OcclusionObject, mBoundsMin));
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(/* index         = */ 1,
+                              /* size          = */ 3,
+                              /* type          = */ GL_FLOAT,
+                              /* normalized    = */ GL_FALSE,
+                              /* stride        = */ sizeof(OcclusionObject),
+                              /* offset        = */ (const void *)offsetof(OcclusionObject, mBoundsMax));
+        glEnableVertexAttribArray(1);
+        glVertexAttribIPointer(/* index         = */ 2,
+                               /* size          = */ 2,
+                               /* type          = */ GL_UNSIGNED_INT,
+                               /* stride        = */ sizeof(OcclusionObject),
+                               /* offset        = */ (const void *)offsetof(OcclusionObject, mCount));
+        glEnableVertexAttribArray(2);
+        glVertexAttribIPointer(/* index         = */ 3,
+                               /* size          = */ 1,
+                               /* type          = */ GL_INT,
+                               /* stride        = */ sizeof(OcclusionObject),
+                               /* offset        = */ (const void *)offsetof(OcclusionObject, mBaseVertex));
+        glEnableVertexAttribArray(3);
+        glBindVertexArray(0);
+
+        // The pyramid holds depth values and must never be filtered
+        glBindTexture(GL_TEXTURE_2D, mPyramidTexture);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+                        GL_NEAREST_MIPMAP_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+        // glad only covers OpenGL 4.0, so load the multi-draw entry point
+        // through the caller's loader where the driver supports it
+        GLint extensionCount = 0;
+        if (aLoader)
+        {
+            glGetIntegerv(GL_NUM_EXTENSIONS, &extensionCount);
+        }
+        for (GLint i = 0; i < extensionCount; ++i)
+        {
+            const char *extension = reinterpret_cast<const char *>(
+                glGetStringi(GL_EXTENSIONS, static_cast<GLuint>(i)));
+            if (0 == std::strcmp(extension, "GL_ARB_multi_draw_indirect"))
+            {
+                mMultiDrawElementsIndirect =
+                    reinterpret_cast<MultiDrawElementsIndirectFunction>(
+                        aLoader("glMultiDrawElementsIndirect"));
+                break;
+            }
+        }
+
+        ResourceRegistry &registry = ResourceRegistry::Default();
+        mObjectResource = registry.Register(ResourceType::Buffer, 0,
+                                            "occlusion:objects");
+        mCommandResource = registry.Register(ResourceType::Buffer, 0,
+                                             "occlusion:commands");
+        mPyramidResource = registry.Register(ResourceType::Texture, 0,
+                                             "occlusion:pyramid");
+        mReadbackResource = registry.Register(ResourceType::Buffer, 0,
+                                              "occlusion:readback");
+    }
+
+    OcclusionCuller::~OcclusionCuller()
+    {
+        ResourceRegistry &registry = ResourceRegistry::Default();
+        registry.Unregister(mObjectResource);
+        registry.Unregister(mCommandResource);
+        registry.Unregister(mPyramidResource);
+        registry.Unregister(mReadbackResource);
+
+        for (Readback &readback : mReadbacks)
+        {
+            if (readback.mFence)
+            {
+                glDeleteSync(readback.mFence);
+            }
+            glDeleteBuffers(1, &readback.mBuffer);
+        }
+        glDeleteTextures(1, &mPyramidTexture);
+        glDeleteFramebuffers(1, &mFramebuffer);
+        glDeleteBuffers(1, &mCommandBuffer);
+        glDeleteBuffers(1, &mObjectBuffer);
+        glDeleteVertexArrays(1, &mObjectVertexArrayObject);
+        glDeleteVertexArrays(1, &mEmptyVertexArrayObject);
+    }
+
+    void OcclusionCuller::SetObjects(
+        const std::vector<OcclusionObject> &aObjects)
+    {
+        mObjectCount = aObjects.size();
+
+        // Until the first call to Cull everything is drawn
+        std::vector<DrawCommand> commands(mObjectCount);
+        for (std::size_t i = 0; i < mObjectCount; ++i)
+        {
+            commands[i] = {aObjects[i].mCount, 1, aObjects[i].mFirstIndex,
+                           aObjects[i].mBaseVertex, 0};
+        }
+
+        const std::size_t objectBytes = mObjectCount * sizeof(OcclusionObject);
+        const std::size_t commandBytes = mObjectCount * sizeof(DrawCommand);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, mObjectBuffer);
+        glBufferData(GL_COPY_WRITE_BUFFER, objectBytes, aObjects.data(),
+                     GL_STATIC_DRAW);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, mCommandBuffer);
+        glBufferData(GL_COPY_WRITE_BUFFER, commandBytes, commands.data(),
+                     GL_DYNAMIC_COPY);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+        ResourceRegistry &registry = ResourceRegistry::Default();
+        registry.Resize(mObjectResource, objectBytes);
+        registry.Resize(mCommandResource, commandBytes);
+    }
+
+    void OcclusionCuller::BuildPyramid(
+        GLuint aDepthTexture,
+        int aWidth,
+        int aHeight,
+        const float *aViewProjection)
+    {
+        if (aWidth <= 0 || aHeight <= 0)
+        {
+            return;
+        }
+
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, mPyramidTexture);
+        if (aWidth != mPyramidWidth || aHeight != mPyramidHeight)
+        {
+            mPyramidWidth = aWidth;
+            mPyramidHeight = aHeight;
+            mPyramidLevels = 1;
+            while (std::max(aWidth, aHeight) >> mPyramidLevels)
+            {
+                ++mPyramidLevels;
+            }
+
+            std::size_t bytes = 0;
+            for (int level = 0; level < mPyramidLevels; ++level)
+            {
+                const int width = detail::HiZLevelSize(aWidth, level);
+                const int height = detail::HiZLevelSize(aHeight, level);
+                glTexImage2D(/* target         = */ GL_TEXTURE_2D,
+                             /* level          = */ level,
+                             /* internalFormat = */ GL_R32F,
+                             /* width          = */ width,
+                             /* height         = */ height,
+                             /* border         = */ 0,
+                             /* format         = */ GL_RED,
+                             /* type           = */ GL_FLOAT,
+                             /* data           = */ nullptr);
+                bytes += static_cast<std::size_t>(width) * height *
+                         sizeof(float);
+            }
+            ResourceRegistry::Default().Resize(mPyramidResource, bytes);
+        }
+
+        GLint viewport[4];
+        GLint framebuffer;
+        glGetIntegerv(GL_VIEWPORT, viewport);
+        glGetIntegerv(GL_FRAMEBUFFER_BINDING, &framebuffer);
+        const GLboolean depthTest = glIsEnabled(GL_DEPTH_TEST);
+        const GLboolean blend = glIsEnabled(GL_BLEND);
+        glDisable(GL_DEPTH_TEST);
+        glDisable(GL_BLEND);
+
+        glBindFramebuffer(GL_FRAMEBUFFER, mFramebuffer);
+        glBindVertexArray(mEmptyVertexArrayObject);
+
+        // Level 0 is a plain copy of the depth texture
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                               GL_TEXTURE_2D, mPyramidTexture, 0);
+        glViewport(0, 0, aWidth, aHeight);
+        mCopyShader.Use();
+        mCopyShader.SetIntegerUniform("depthTexture", 0);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, aDepthTexture);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+
+        // Each further level is reduced from the one before. Restricting the
+        // accessible levels to the previous one avoids a feedback loop with
+        // the level being rendered.
+        mReduceShader.Use();
+        mReduceShader.SetIntegerUniform("previousLevel", 0);
+        glBindTexture(GL_TEXTURE_2D, mPyramidTexture);
+        for (int level = 1; level < mPyramidLevels; ++level)
+        {
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level - 1);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, level - 1);
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                                   GL_TEXTURE_2D, mPyramidTexture, level);
+            glViewport(0, 0, detail::HiZLevelSize(aWidth, level),
+                       detail::HiZLevelSize(aHeight, level));
+            glDrawArrays(GL_TRIANGLES, 0, 3);
+        }
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL,
+                        mPyramidLevels - 1);
+
+        glBindVertexArray(0);
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+        if (depthTest)
+        {
+            glEnable(GL_DEPTH_TEST);
+        }
+        if (blend)
+        {
+            glEnable(GL_BLEND);
+        }
+
+        std::memcpy(mPyramidViewProjection, aViewProjection,
+                    sizeof(mPyramidViewProjection));
+        ResourceRegistry::Default().Touch(mPyramidResource);
+    }
+
+    void OcclusionCuller::Cull(
+        const float *aViewProjection)
+    {
+        PollReadbacks();
+        if (0 == mObjectCount)
+        {
+            ++mFrame;
+            return;
+        }
+
+        mCullShader.Use();
+        mCullShader.SetMatrixUniform("viewProjection", aViewProjection);
+        mCullShader.SetMatrixUniform("occlusionViewProjection",
+                                     mPyramidLevels ? mPyramidViewProjection
+                                                    : aViewProjection);
+        mCullShader.SetIntegerUniform("pyramid", 0);
+        mCullShader.SetIntegerUniform("pyramidLevels", mPyramidLevels);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, mPyramidTexture);
+
+        // One point per object, each written back as one draw command
+        glEnable(GL_RASTERIZER_DISCARD);
+        glBindVertexArray(mObjectVertexArrayObject);
+        glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, mCommandBuffer);
+        glBeginTransformFeedback(GL_POINTS);
+        glDrawArrays(GL_POINTS, 0, static_cast<GLsizei>(mObjectCount));
+        glEndTransformFeedback();
+        glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0);
+        glBindVertexArray(0);
+        glDisable(GL_RASTERIZER_DISCARD);
+
+        // Queue a copy of the commands for the statistics. If all copies are
+        // still in flight this frame is skipped rather than waited for.
+        const std::size_t commandBytes = mObjectCount * sizeof(DrawCommand);
+        for (Readback &readback : mReadbacks)
+        {
+            if (readback.mFence)
+            {
+                continue;
+            }
+
+            glBindBuffer(GL_COPY_READ_BUFFER, mCommandBuffer);
+            glBindBuffer(GL_COPY_WRITE_BUFFER, readback.mBuffer);
+            if (readback.mCapacity < commandBytes)
+            {
+                glBufferData(GL_COPY_WRITE_BUFFER, commandBytes, nullptr,
+                             GL_STREAM_READ);
+                readback.mCapacity = commandBytes;
+
+                std::size_t readbackBytes = 0;
+                for (const Readback &other : mReadbacks)
+                {
+                    readbackBytes += other.mCapacity;
+                }
+                ResourceRegistry::Default().Resize(mReadbackResource,
+                                                   readbackBytes);
+            }
+            glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0,
+                                0, commandBytes);
+            glBindBuffer(GL_COPY_READ_BUFFER, 0);
+            glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+            readback.mFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+            readback.mFrame = mFrame;
+            readback.mObjectCount = mObjectCount;
+            break;
+        }
+
+        ResourceRegistry &registry = ResourceRegistry::Default();
+        registry.Touch(mObjectResource);
+        registry.Touch(mCommandResource);
+        registry.Touch(mPyramidResource);
+        registry.Touch(mReadbackResource);
+        ++mFrame;
+    }
+
+    void OcclusionCuller::Draw(
+        GLenum aMode,
+        GLenum aIndexType,
+        std::size_t aFirst,
+        std::size_t aCount) const
+    {
+        if (aFirst >= mObjectCount)
+        {
+            return;
+        }
+        const std::size_t last = aFirst + std::min(aCount,
+                                                   mObjectCount - aFirst);
+
+        // Culled objects have no instances and cost no vertex work
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, mCommandBuffer);
+        if (mMultiDrawElementsIndirect)
+        {
+            mMultiDrawElementsIndirect(
+                aMode, aIndexType,
+                (const void *)(aFirst * sizeof(DrawCommand)),
+                static_cast<GLsizei>(last - aFirst), sizeof(DrawCommand));
+        }
+        else
+        {
+            // OpenGL 4.0 fallback, each object takes its own call
+            for (std::size_t i = aFirst; i < last; ++i)
+            {
+                glDrawElementsIndirect(aMode, aIndexType,
+                                       (const void *)(i * sizeof(DrawCommand)));
+            }
+        }
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    }
+
+    GLuint OcclusionCuller::CommandBuffer() const noexcept
+    {
+        return mCommandBuffer;
+    }
+
+    const OcclusionStats &OcclusionCuller::Stats() const noexcept
+    {
+        return mStats;
+    }
+
+    void OcclusionCuller::PollReadbacks()
+    {
+        for (Readback &readback : mReadbacks)
+        {
+            if (!readback.mFence)
+            {
+                continue;
+            }
+
+            const GLenum status = glClientWaitSync(readback.mFence, 0, 0);
+            if (GL_TIMEOUT_EXPIRED == status)
+            {
+                continue;
+            }
+            glDeleteSync(readback.mFence);
+            readback.mFence = nullptr;
+            if (GL_WAIT_FAILED == status || readback.mFrame < mStats.mFrame)
+            {
+                continue;
+            }
+
+            glBindBuffer(GL_COPY_READ_BUFFER, readback.mBuffer);
+            const DrawCommand *commands = static_cast<const DrawCommand *>(
+                glMapBufferRange(GL_COPY_READ_BUFFER, 0,
+                                 readback.mObjectCount * sizeof(DrawCommand),
+                                 GL_MAP_READ_BIT));
+            if (commands)
+            {
+                std::size_t visible = 0;
+                for (std::size_t i = 0; i < readback.mObjectCount; ++i)
+                {
+                    visible += commands[i].mInstanceCount;
+                }
+                glUnmapBuffer(GL_COPY_READ_BUFFER);
+
+                mStats.mFrame = readback.mFrame;
+                mStats.mObjectCount = readback.mObjectCount;
+                mStats.mVisibleCount = visible;
+                mStats.mCulledCount = readback.mObjectCount - visible;
+            }
+            glBindBuffer(GL_COPY_READ_BUFFER, 0);
+        }
+    }
+
+} // namespace Glance
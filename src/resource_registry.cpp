@@ -0,0 +1,417 @@
+/**
+ * Copyright 2021 Christoph Groß
+ *
+ * This file is part of Glance.
+ *
+ * Glance is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Glance is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Glance.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <glad/glad.h>
+
+#include "resource_registry.hpp"
+
+// Tokens of GL_NVX_gpu_memory_info and GL_ATI_meminfo, in case the loader was
+// generated without these extensions.
+#ifndef GL_GPU_MEMORY_INFO_CURRENT_AVAILABLE_VIDMEM_NVX
+#define GL_GPU_MEMORY_INFO_CURRENT_AVAILABLE_VIDMEM_NVX 0x9049
+#endif
+#ifndef GL_TEXTURE_FREE_MEMORY_ATI
+#define GL_TEXTURE_FREE_MEMORY_ATI 0x87FC
+#endif
+
+namespace
+{
+
+    // Bits of a ResourceId holding the slot
+    constexpr Glance::ResourceId IndexMask =
+        (Glance::ResourceId(1) << Glance::ResourceIndexBits) - 1;
+    // Generations wrap around within the remaining upper bits
+    constexpr std::uint32_t GenerationMask =
+        ~Glance::ResourceId(0) >> Glance::ResourceIndexBits;
+
+} // namespace
+
+namespace Glance
+{
+
+    ResourceRegistry::ResourceRegistry(
+        std::size_t aFallbackBudgetBytes)
+        : mFallbackBudget(aFallbackBudgetBytes),
+          mBudgetLimit(),
+          mBudget(aFallbackBudgetBytes),
+          mResidentBytes(0),
+          mFrame(0),
+          mFreeMemory(),
+          mMinimumFree(64u << 20),
+          mMaxEvictions(4),
+          mStats()
+    {
+    }
+
+    ResourceRegistry &ResourceRegistry::Default()
+    {
+        static ResourceRegistry registry(256u << 20);
+        return registry;
+    }
+
+    bool ResourceRegistry::QueryDeviceBudget()
+    {
+        GLint extensionCount = 0;
+        glGetIntegerv(GL_NUM_EXTENSIONS, &extensionCount);
+
+        // Both extensions report the free memory in KiB
+        GLenum query = GL_NONE;
+        for (GLint i = 0; i < extensionCount && GL_NONE == query; ++i)
+        {
+            const char *extension = reinterpret_cast<const char *>(
+                glGetStringi(GL_EXTENSIONS, static_cast<GLuint>(i)));
+            if (0 == std::strcmp(extension, "GL_NVX_gpu_memory_info"))
+            {
+                query = GL_GPU_MEMORY_INFO_CURRENT_AVAILABLE_VIDMEM_NVX;
+            }
+            else if (0 == std::strcmp(extension, "GL_ATI_meminfo"))
+            {
+                query = GL_TEXTURE_FREE_MEMORY_ATI;
+            }
+        }
+
+        if (GL_NONE == query)
+        {
+            SetFreeMemorySource(FreeMemorySource());
+            return false;
+        }
+        SetFreeMemorySource(
+            [query]()
+            {
+                GLint freeKiB[4] = {};
+                glGetIntegerv(query, freeKiB);
+                return static_cast<std::size_t>(std::max(0, freeKiB[0])) *
+                       1024;
+            });
+        return true;
+    }
+
+    void ResourceRegistry::SetFreeMemorySource(
+        FreeMemorySource aSource)
+    {
+        mFreeMemory = std::move(aSource);
+        UpdateBudget();
+    }
+
+    void ResourceRegistry::SetMinimumFree(
+        std::size_t aMinimumFreeBytes) noexcept
+    {
+        mMinimumFree = aMinimumFreeBytes;
+    }
+
+    void ResourceRegistry::SetMaxEvictionsPerFrame(
+        std::size_t aMaxEvictions) noexcept
+    {
+        mMaxEvictions = aMaxEvictions;
+    }
+
+    void ResourceRegistry::SetBudget(
+        std::optional<std::size_t> aBudgetBytes) noexcept
+    {
+        mBudgetLimit = aBudgetBytes;
+        if (!mFreeMemory)
+        {
+            mBudget = mBudgetLimit.value_or(mFallbackBudget);
+        }
+        else if (mBudgetLimit)
+        {
+            mBudget = std::min(mBudget, *mBudgetLimit);
+        }
+    }
+
+    std::size_t ResourceRegistry::Budget() const noexcept
+    {
+        return mBudget;
+    }
+
+    void ResourceRegistry::UpdateBudget()
+    {
+        if (!mFreeMemory)
+        {
+            mBudget = mBudgetLimit.value_or(mFallbackBudget);
+            return;
+        }
+
+        // The memory of our own resources is already taken from the free
+        // memory. Whatever the device lacks of the minimum has to come out
+        // of our resources. The fallback budget plays no part here, the
+        // device knows better.
+        const std::size_t available = mResidentBytes + mFreeMemory();
+        const std::size_t deviceBudget =
+            available > mMinimumFree ? available - mMinimumFree : 0;
+        mBudget = mBudgetLimit ? std::min(*mBudgetLimit, deviceBudget)
+                               : deviceBudget;
+    }
+
+    ResourceId ResourceRegistry::Register(
+        ResourceType aType,
+        std::size_t aBytes,
+        std::string aOwner,
+        EvictCallback aEvict,
+        RestoreCallback aRestore)
+    {
+        std::size_t slot;
+        if (mFreeSlots.empty())
+        {
+            if (mEntries.size() >= IndexMask)
+            {
+                throw std::length_error("Too many registered resources");
+            }
+            slot = mEntries.size();
+            mEntries.emplace_back();
+            mEntries[slot].mGeneration = 0;
+        }
+        else
+        {
+            slot = mFreeSlots.back();
+            mFreeSlots.pop_back();
+        }
+
+        Entry &entry = mEntries[slot];
+        entry.mType = aType;
+        entry.mBytes = aBytes;
+        entry.mFullBytes = aBytes;
+        entry.mLastUsedFrame = mFrame;
+        entry.mOwner = std::move(aOwner);
+        entry.mEvict = std::move(aEvict);
+        entry.mRestore = std::move(aRestore);
+        entry.mRegistered = true;
+
+        mResidentBytes += aBytes;
+        return (entry.mGeneration << ResourceIndexBits) |
+               static_cast<ResourceId>(slot + 1);
+    }
+
+    void ResourceRegistry::Unregister(
+        ResourceId aId) noexcept
+    {
+        Entry *entry = Find(aId);
+        if (entry)
+        {
+            mResidentBytes -= entry->mBytes;
+            entry->mRegistered = false;
+            entry->mEvict = EvictCallback();
+            entry->mRestore = RestoreCallback();
+            // Invalidate all outstanding handles of the slot
+            entry->mGeneration = (entry->mGeneration + 1) & GenerationMask;
+            mFreeSlots.push_back((aId & IndexMask) - 1);
+        }
+    }
+
+    void ResourceRegistry::Resize(
+        ResourceId aId,
+        std::size_t aBytes) noexcept
+    {
+        Entry *entry = Find(aId);
+        if (entry)
+        {
+            mResidentBytes = mResidentBytes - entry->mBytes + aBytes;
+            entry->mBytes = aBytes;
+            entry->mFullBytes = aBytes;
+        }
+    }
+
+    void ResourceRegistry::Touch(
+        ResourceId aId) noexcept
+    {
+        Entry *entry = Find(aId);
+        if (entry)
+        {
+            entry->mLastUsedFrame = mFrame;
+        }
+    }
+
+    void ResourceRegistry::EndFrame()
+    {
+        UpdateBudget();
+
+        const std::size_t evictions = Evict();
+        // Never restore in the same frame we had to evict in, that would
+        // only thrash.
+        const std::size_t restores = evictions ? 0 : Restore();
+
+        ResidencyStats stats = {};
+        stats.mFrame = mFrame;
+        stats.mBudgetBytes = mBudget;
+        stats.mResidentBytes = mResidentBytes;
+        stats.mEvictions = evictions;
+        stats.mRestores = restores;
+        for (const Entry &entry : mEntries)
+        {
+            if (!entry.mRegistered)
+            {
+                continue;
+            }
+            ++stats.mResourceCount;
+            if (ResourceType::Texture == entry.mType)
+            {
+                stats.mTextureBytes += entry.mBytes;
+            }
+            else
+            {
+                stats.mBufferBytes += entry.mBytes;
+            }
+            if (mFrame == entry.mLastUsedFrame)
+            {
+                ++stats.mUsedCount;
+            }
+            if (entry.mBytes < entry.mFullBytes)
+            {
+                ++stats.mReducedCount;
+            }
+        }
+        mStats = stats;
+
+        ++mFrame;
+    }
+
+    const ResidencyStats &ResourceRegistry::Stats() const noexcept
+    {
+        return mStats;
+    }
+
+    std::size_t ResourceRegistry::Bytes(
+        ResourceId aId) const noexcept
+    {
+        const Entry *entry = Find(aId);
+        return entry ? entry->mBytes : 0;
+    }
+
+    const std::string &ResourceRegistry::Owner(
+        ResourceId aId) const noexcept
+    {
+        static const std::string none;
+        const Entry *entry = Find(aId);
+        return entry ? entry->mOwner : none;
+    }
+
+    ResourceRegistry::Entry *ResourceRegistry::Find(
+        ResourceId aId) noexcept
+    {
+        const std::size_t index = aId & IndexMask;
+        if (0 == index || index > mEntries.size())
+        {
+            return nullptr;
+        }
+        Entry &entry = mEntries[index - 1];
+        if (!entry.mRegistered ||
+            entry.mGeneration != aId >> ResourceIndexBits)
+        {
+            return nullptr;
+        }
+        return &entry;
+    }
+
+    const ResourceRegistry::Entry *ResourceRegistry::Find(
+        ResourceId aId) const noexcept
+    {
+        return const_cast<ResourceRegistry *>(this)->Find(aId);
+    }
+
+    std::size_t ResourceRegistry::Evict()
+    {
+        if (mResidentBytes <= mBudget)
+        {
+            return 0;
+        }
+
+        // Candidates are streamable resources not used in this frame, least
+        // recently used first
+        std::vector<std::size_t> candidates;
+        for (std::size_t i = 0; i < mEntries.size(); ++i)
+        {
+            const Entry &entry = mEntries[i];
+            if (entry.mRegistered && entry.mEvict &&
+                entry.mLastUsedFrame < mFrame)
+            {
+                candidates.push_back(i);
+            }
+        }
+        std::stable_sort(candidates.begin(), candidates.end(),
+                         [this](std::size_t aLeft, std::size_t aRight)
+                         {
+                             return mEntries[aLeft].mLastUsedFrame <
+                                    mEntries[aRight].mLastUsedFrame;
+                         });
+
+        // Each resource is asked once for everything still missing, so it
+        // can shrink in a single step before moving on to the next, more
+        // recently used one
+        std::size_t evictions = 0;
+        for (std::size_t slot : candidates)
+        {
+            if (mResidentBytes <= mBudget || evictions >= mMaxEvictions)
+            {
+                break;
+            }
+
+            EvictCallback evict = mEntries[slot].mEvict;
+            const std::size_t bytes = evict(mResidentBytes - mBudget);
+            Entry &entry = mEntries[slot];
+            if (bytes < entry.mBytes)
+            {
+                mResidentBytes -= entry.mBytes - bytes;
+                entry.mBytes = bytes;
+                ++evictions;
+            }
+        }
+        return evictions;
+    }
+
+    std::size_t ResourceRegistry::Restore()
+    {
+        // Only resources that are in use right now are worth restoring.
+        // Restoring the smallest one per frame keeps the cost of each frame
+        // bounded.
+        std::size_t candidate = mEntries.size();
+        for (std::size_t i = 0; i < mEntries.size(); ++i)
+        {
+            const Entry &entry = mEntries[i];
+            if (entry.mRegistered && entry.mRestore &&
+                entry.mBytes < entry.mFullBytes &&
+                mFrame == entry.mLastUsedFrame &&
+                mResidentBytes - entry.mBytes + entry.mFullBytes <= mBudget &&
+                (mEntries.size() == candidate ||
+                 entry.mFullBytes < mEntries[candidate].mFullBytes))
+            {
+                candidate = i;
+            }
+        }
+        if (mEntries.size() == candidate)
+        {
+            return 0;
+        }
+
+        RestoreCallback restore = mEntries[candidate].mRestore;
+        const std::size_t bytes = restore();
+        Entry &entry = mEntries[candidate];
+        mResidentBytes = mResidentBytes - entry.mBytes + bytes;
+        entry.mBytes = bytes;
+        entry.mFullBytes = std::max(entry.mFullBytes, bytes);
+        return 1;
+    }
+
+} // namespace Glance
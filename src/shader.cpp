@@ -63,20 +63,73 @@ namespace Glance
             throw ShaderException(errorMsg);
         }
 
-        const char *vertexSourcePtr = vertexSource.c_str();
-        const char *fragmentSourcePtr = fragmentSource.c_str();
+        Build(vertexSource, fragmentSource);
+    }
+
+    Shader::Shader(
+        const Vfs &aVfs,
+        const std::string &aVertexPath,
+        const std::string &aFragmentPath)
+    {
+        std::string_view vertexSource;
+        std::string_view fragmentSource;
+
+        try
+        {
+            vertexSource = aVfs.Read(aVertexPath);
+            fragmentSource = aVfs.Read(aFragmentPath);
+        }
+        catch (const VfsException &e)
+        {
+            std::string errorMsg = "Exception while reading shader source: ";
+            errorMsg += e.what();
+            throw ShaderException(errorMsg);
+        }
+
+        Build(vertexSource, fragmentSource);
+    }
+
+    Shader::Shader()
+        : mProgramId(0)
+    {
+    }
+
+    Shader Shader::FromSource(
+        std::string_view aVertexSource,
+        std::string_view aFragmentSource,
+        const std::vector<const char *> &aFeedbackVaryings)
+    {
+        Shader shader;
+        shader.Build(aVertexSource, aFragmentSource, aFeedbackVaryings);
+        return shader;
+    }
+
+    void Shader::Build(
+        std::string_view aVertexSource,
+        std::string_view aFragmentSource,
+        const std::vector<const char *> &aFeedbackVaryings)
+    {
+        // Pass explicit lengths, the sources need not be null-terminated
+        const char *vertexSourcePtr = aVertexSource.data();
+        const char *fragmentSourcePtr = aFragmentSource.data();
+        const GLint vertexSourceLength = static_cast<GLint>(
+            aVertexSource.size());
+        const GLint fragmentSourceLength = static_cast<GLint>(
+            aFragmentSource.size());
 
         GLuint vertexShaderId, fragmentShaderId;
 
         vertexShaderId = glCreateShader(GL_VERTEX_SHADER);
-        glShaderSource(vertexShaderId, 1, &vertexSourcePtr, nullptr);
+        glShaderSource(vertexShaderId, 1, &vertexSourcePtr,
+                       &vertexSourceLength);
         glCompileShader(vertexShaderId);
         if (!ShaderCompiled(vertexShaderId))
         {
             /// @todo #4 Errorhandling
         }
         fragmentShaderId = glCreateShader(GL_FRAGMENT_SHADER);
-        glShaderSource(fragmentShaderId, 1, &fragmentSourcePtr, nullptr);
+        glShaderSource(fragmentShaderId, 1, &fragmentSourcePtr,
+                       &fragmentSourceLength);
         glCompileShader(fragmentShaderId);
         if (!ShaderCompiled(fragmentShaderId))
         {
@@ -86,6 +139,13 @@ namespace Glance
         mProgramId = glCreateProgram();
         glAttachShader(mProgramId, vertexShaderId);
         glAttachShader(mProgramId, fragmentShaderId);
+        // Transform feedback outputs have to be known before linking
+        if (!aFeedbackVaryings.empty())
+        {
+            glTransformFeedbackVaryings(
+                mProgramId, static_cast<GLsizei>(aFeedbackVaryings.size()),
+                aFeedbackVaryings.data(), GL_INTERLEAVED_ATTRIBS);
+        }
         glLinkProgram(mProgramId);
         if (!ShaderLinked(mProgramId))
         {
@@ -253,6 +313,26 @@ namespace Glance
         }
     }
 
+    void Shader::SetMatrixUniform(
+        const std::string &aName,
+        const float *aValue)
+    {
+        GLint location = glGetUniformLocation(mProgramId, aName.c_str());
+        if (-1 == location)
+        {
+            std::cerr << "ERROR: Could not find uniform " << aName
+                      << ". This means that " << aName
+                      << " does not correspond to an active uniform in this "
+                      << "shader program or that the specified name is "
+                      << "reserved by OpenGL." << std::endl;
+            /// @todo #4 Error handling?
+        }
+        else
+        {
+            glUniformMatrix4fv(location, 1, GL_FALSE, aValue);
+        }
+    }
+
     ShaderException::ShaderException(
         std::string aErrorMsg) noexcept
         : mErrorMsg(aErrorMsg)
@@ -0,0 +1,333 @@
+/**
+ * Copyright 2021 Christoph Groß
+ *
+ * This file is part of Glance.
+ *
+ * Glance is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Glance is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Glance.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+#include "sprite_batch.hpp"
+
+namespace
+{
+
+    const char *const SpriteVertexShader = R"(#version 400 core
+
+layout ( location = 0 ) in vec2 aPosition;
+layout ( location = 1 ) in vec2 aTextureCoord;
+layout ( location = 2 ) in vec4 aColor;
+
+// xy scales pixels to normalized device coordinates, zw is the offset
+uniform vec4 transform;
+
+out vec2 textureCoord;
+out vec4 color;
+
+void main()
+{
+    gl_Position = vec4( aPosition * transform.xy + transform.zw, 0.0, 1.0 );
+    textureCoord = aTextureCoord;
+    color = aColor;
+}
+)";
+
+    const char *const SpriteFragmentShader = R"(#version 400 core
+
+in vec2 textureCoord;
+in vec4 color;
+
+out vec4 fragmentColor;
+
+uniform sampler2D textureSampler;
+
+void main()
+{
+    fragmentColor = texture( textureSampler, textureCoord ) * color;
+}
+)";
+
+} // namespace
+
+namespace Glance
+{
+
+    SpriteBatch::SpriteBatch()
+        : mShader(Shader::FromSource(SpriteVertexShader, SpriteFragmentShader)),
+          mVertexArrayObject(0),
+          mVertexBufferObject(0),
+          mElementBufferObject(0),
+          mVertexBufferResource(0),
+          mElementBufferResource(0),
+          mBufferQuad(0),
+          mViewportWidth(1),
+          mViewportHeight(1),
+          mSortMode(SpriteSortMode::Texture),
+          mSpriteCount(0),
+          mDrawCallCount(0)
+    {
+        // Every quad uses the same two triangles, so a single index buffer
+        // covering the largest draw is shared by all draws. The quads are
+        // selected with the base vertex of each draw.
+        std::vector<GLushort> indices(MaxQuadsPerDraw * 6);
+        for (std::size_t quad = 0; quad < MaxQuadsPerDraw; ++quad)
+        {
+            const GLushort vertex = static_cast<GLushort>(quad * 4);
+            GLushort *index = &indices[quad * 6];
+            index[0] = vertex;
+            index[1] = vertex + 1;
+            index[2] = vertex + 2;
+            index[3] = vertex + 2;
+            index[4] = vertex + 3;
+            index[5] = vertex;
+        }
+        const std::size_t vertexBytes = BufferQuads * 4 * sizeof(Vertex);
+        const std::size_t indexBytes = indices.size() * sizeof(GLushort);
+
+        glGenVertexArrays(1, &mVertexArrayObject);
+        glGenBuffers(1, &mVertexBufferObject);
+        glGenBuffers(1, &mElementBufferObject);
+
+        glBindVertexArray(mVertexArrayObject);
+        glBindBuffer(GL_ARRAY_BUFFER, mVertexBufferObject);
+        glBufferData(GL_ARRAY_BUFFER, vertexBytes, nullptr, GL_STREAM_DRAW);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mElementBufferObject);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexBytes, indices.data(),
+                     GL_STATIC_DRAW);
+        glVertexAttribPointer(/* index         = */ 0,
+                              /* size          = */ 2,
+                              /* type          = */ GL_FLOAT,
+                              /* normalized    = */ GL_FALSE,
+                              /* stride        = */ sizeof(Vertex),
+                              /* offset        = */ (const void *)offsetof(Vertex, mX));
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(/* index         = */ 1,
+                              /* size          = */ 2,
+                              /* type          = */ GL_FLOAT,
+                              /* normalized    = */ GL_FALSE,
+                              /* stride        = */ sizeof(Vertex),
+                              /* offset        = */ (const void *)offsetof(Vertex, mU));
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(/* index         = */ 2,
+                              /* size          = */ 4,
+                              /* type          = */ GL_UNSIGNED_BYTE,
+                              /* normalized    = */ GL_TRUE,
+                              /* stride        = */ sizeof(Vertex),
+                              /* offset        = */ (const void *)offsetof(Vertex, mColor));
+        glEnableVertexAttribArray(2);
+        glBindVertexArray(0);
+
+        ResourceRegistry &registry = ResourceRegistry::Default();
+        mVertexBufferResource = registry.Register(
+            ResourceType::Buffer, vertexBytes, "sprite_batch:vertices");
+        mElementBufferResource = registry.Register(
+            ResourceType::Buffer, indexBytes, "sprite_batch:indices");
+    }
+
+    SpriteBatch::~SpriteBatch()
+    {
+        ResourceRegistry &registry = ResourceRegistry::Default();
+        registry.Unregister(mVertexBufferResource);
+        registry.Unregister(mElementBufferResource);
+
+        glDeleteVertexArrays(1, &mVertexArrayObject);
+        glDeleteBuffers(1, &mVertexBufferObject);
+        glDeleteBuffers(1, &mElementBufferObject);
+    }
+
+    void SpriteBatch::Begin(
+        int aViewportWidth,
+        int aViewportHeight,
+        SpriteSortMode aSortMode)
+    {
+        mViewportWidth = std::max(1, aViewportWidth);
+        mViewportHeight = std::max(1, aViewportHeight);
+        mSortMode = aSortMode;
+        mSprites.clear();
+    }
+
+    void SpriteBatch::Draw(
+        GLuint aTexture,
+        const SpriteRect &aDestination,
+        const SpriteRect &aSource,
+        std::uint32_t aColor)
+    {
+        mSprites.push_back({aTexture, aColor, aDestination, aSource});
+    }
+
+    void SpriteBatch::Draw(
+        const Texture &aTexture,
+        const SpriteRect &aDestination,
+        const SpriteRect &aSource,
+        std::uint32_t aColor)
+    {
+        aTexture.MarkUsed();
+        Draw(aTexture.Id(), aDestination, aSource, aColor);
+    }
+
+    void SpriteBatch::End()
+    {
+        mSpriteCount = mSprites.size();
+        mDrawCallCount = 0;
+        if (mSprites.empty())
+        {
+            return;
+        }
+
+        // The upper half of a key holds the texture and the lower half the
+        // position in the queue, so sorting the keys groups sprites by
+        // texture while keeping their order within each group.
+        mKeys.resize(mSprites.size());
+        for (std::size_t i = 0; i < mSprites.size(); ++i)
+        {
+            mKeys[i] = static_cast<std::uint64_t>(i);
+            if (SpriteSortMode::Texture == mSortMode)
+            {
+                mKeys[i] |= static_cast<std::uint64_t>(mSprites[i].mTexture)
+                            << 32;
+            }
+        }
+        if (SpriteSortMode::Texture == mSortMode)
+        {
+            std::sort(mKeys.begin(), mKeys.end());
+        }
+
+        GLint blendSourceRgb, blendDestinationRgb;
+        GLint blendSourceAlpha, blendDestinationAlpha;
+        const GLboolean blend = glIsEnabled(GL_BLEND);
+        const GLboolean depthTest = glIsEnabled(GL_DEPTH_TEST);
+        glGetIntegerv(GL_BLEND_SRC_RGB, &blendSourceRgb);
+        glGetIntegerv(GL_BLEND_DST_RGB, &blendDestinationRgb);
+        glGetIntegerv(GL_BLEND_SRC_ALPHA, &blendSourceAlpha);
+        glGetIntegerv(GL_BLEND_DST_ALPHA, &blendDestinationAlpha);
+
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        glDisable(GL_DEPTH_TEST);
+
+        mShader.Use();
+        mShader.SetFloatUniform("transform",
+                                2.f / mViewportWidth, -2.f / mViewportHeight,
+                                -1.f, 1.f);
+        mShader.SetIntegerUniform("textureSampler", 0);
+        glActiveTexture(GL_TEXTURE0);
+        glBindVertexArray(mVertexArrayObject);
+        glBindBuffer(GL_ARRAY_BUFFER, mVertexBufferObject);
+
+        for (std::size_t first = 0; first < mKeys.size();)
+        {
+            const std::size_t count = std::min(MaxQuadsPerDraw,
+                                               mKeys.size() - first);
+
+            // Orphan the buffer once it is full instead of waiting for the
+            // GPU to finish reading it. Below that, each chunk is written to
+            // a region the GPU is not using, so no synchronization is needed.
+            if (mBufferQuad + count > BufferQuads)
+            {
+                glBufferData(GL_ARRAY_BUFFER,
+                             BufferQuads * 4 * sizeof(Vertex), nullptr,
+                             GL_STREAM_DRAW);
+                mBufferQuad = 0;
+            }
+
+            Vertex *vertex = static_cast<Vertex *>(glMapBufferRange(
+                GL_ARRAY_BUFFER, mBufferQuad * 4 * sizeof(Vertex),
+                count * 4 * sizeof(Vertex),
+                GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT |
+                    GL_MAP_UNSYNCHRONIZED_BIT));
+            if (!vertex)
+            {
+                // Mapping fails e.g. when out of memory, drop this chunk
+                // rather than the whole frame
+                mSpriteCount -= count;
+                first += count;
+                continue;
+            }
+            for (std::size_t i = first; i < first + count; ++i)
+            {
+                const Sprite &sprite = mSprites[mKeys[i] & 0xffffffffu];
+                const SpriteRect &d = sprite.mDestination;
+                const SpriteRect &s = sprite.mSource;
+                *vertex++ = {d.mX + d.mWidth, d.mY, s.mX + s.mWidth, s.mY,
+                             sprite.mColor};
+                *vertex++ = {d.mX + d.mWidth, d.mY + d.mHeight,
+                             s.mX + s.mWidth, s.mY + s.mHeight, sprite.mColor};
+                *vertex++ = {d.mX, d.mY + d.mHeight, s.mX, s.mY + s.mHeight,
+                             sprite.mColor};
+                *vertex++ = {d.mX, d.mY, s.mX, s.mY, sprite.mColor};
+            }
+            glUnmapBuffer(GL_ARRAY_BUFFER);
+
+            // One draw call per run of sprites sharing a texture
+            for (std::size_t run = first; run < first + count;)
+            {
+                const GLuint texture = mSprites[mKeys[run] & 0xffffffffu]
+                                           .mTexture;
+                std::size_t end = run + 1;
+                while (end < first + count &&
+                       texture == mSprites[mKeys[end] & 0xffffffffu].mTexture)
+                {
+                    ++end;
+                }
+
+                glBindTexture(GL_TEXTURE_2D, texture);
+                glDrawElementsBaseVertex(
+                    /* mode       = */ GL_TRIANGLES,
+                    /* count      = */ static_cast<GLsizei>((end - run) * 6),
+                    /* type       = */ GL_UNSIGNED_SHORT,
+                    /* indices    = */ (const void *)0,
+                    /* basevertex = */ static_cast<GLint>(
+                        (mBufferQuad + run - first) * 4));
+                ++mDrawCallCount;
+                run = end;
+            }
+
+            mBufferQuad += count;
+            first += count;
+        }
+
+        glBindVertexArray(0);
+        ResourceRegistry &registry = ResourceRegistry::Default();
+        registry.Touch(mVertexBufferResource);
+        registry.Touch(mElementBufferResource);
+
+        glBlendFuncSeparate(blendSourceRgb, blendDestinationRgb,
+                            blendSourceAlpha, blendDestinationAlpha);
+        if (!blend)
+        {
+            glDisable(GL_BLEND);
+        }
+        if (depthTest)
+        {
+            glEnable(GL_DEPTH_TEST);
+        }
+
+        mSprites.clear();
+    }
+
+    std::size_t SpriteBatch::SpriteCount() const noexcept
+    {
+        return mSpriteCount;
+    }
+
+    std::size_t SpriteBatch::DrawCallCount() const noexcept
+    {
+        return mDrawCallCount;
+    }
+
+} // namespace Glance
@@ -0,0 +1,334 @@
+/**
+ * Copyright 2021 Christoph Groß
+ *
+ * This file is part of Glance.
+ *
+ * Glance is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Glance is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Glance.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+
+#include "texture.hpp"
+
+namespace Glance
+{
+
+    Texture::Texture(
+        const Vfs &aVfs,
+        const std::string &aPath)
+        : mVfs(aVfs),
+          mPath(aPath),
+          mTextureId(0),
+          mWidth(0),
+          mHeight(0),
+          mChannels(0),
+          mDroppedLevels(0),
+          mResourceId(0)
+    {
+        glGenTextures(1, &mTextureId);
+        glBindTexture(GL_TEXTURE_2D, mTextureId);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+                        GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+        try
+        {
+            Upload(0);
+        }
+        catch (const TextureException &)
+        {
+            glDeleteTextures(1, &mTextureId);
+            throw;
+        }
+
+        mResourceId = ResourceRegistry::Default().Register(
+            ResourceType::Texture, Bytes(), "texture:" + mPath,
+            [this](std::size_t aBytesToFree)
+            {
+                return DropLevels(aBytesToFree);
+            },
+            [this]()
+            {
+                GLint boundTexture;
+                glGetIntegerv(GL_TEXTURE_BINDING_2D, &boundTexture);
+                glBindTexture(GL_TEXTURE_2D, mTextureId);
+                try
+                {
+                    Upload(0);
+                }
+                catch (const TextureException &)
+                {
+                    // Keep the reduced levels, a later frame retries
+                }
+                glBindTexture(GL_TEXTURE_2D, boundTexture);
+                return Bytes();
+            });
+    }
+
+    Texture::~Texture()
+    {
+        ResourceRegistry::Default().Unregister(mResourceId);
+        glDeleteTextures(1, &mTextureId);
+    }
+
+    void Texture::Bind() const
+    {
+        MarkUsed();
+        glBindTexture(GL_TEXTURE_2D, mTextureId);
+    }
+
+    void Texture::MarkUsed() const noexcept
+    {
+        ResourceRegistry::Default().Touch(mResourceId);
+    }
+
+    GLuint Texture::Id() const noexcept
+    {
+        return mTextureId;
+    }
+
+    int Texture::Width() const noexcept
+    {
+        return mWidth;
+    }
+
+    int Texture::Height() const noexcept
+    {
+        return mHeight;
+    }
+
+    int Texture::LevelCount() const noexcept
+    {
+        int levels = 1;
+        for (int size = std::max(mWidth, mHeight); size > 1; size >>= 1)
+        {
+            ++levels;
+        }
+        return levels;
+    }
+
+    std::size_t Texture::Bytes() const noexcept
+    {
+        return LevelBytes(mDroppedLevels);
+    }
+
+    std::size_t Texture::LevelBytes(
+        int aDroppedLevels) const noexcept
+    {
+        // Count what the internal format stores, RGB images take 4 bytes
+        const std::size_t bytesPerTexel = 3 == mChannels ? 4 : mChannels;
+        std::size_t bytes = 0;
+        for (int level = aDroppedLevels; level < LevelCount(); ++level)
+        {
+            bytes += static_cast<std::size_t>(std::max(1, mWidth >> level)) *
+                     static_cast<std::size_t>(std::max(1, mHeight >> level)) *
+                     bytesPerTexel;
+        }
+        return bytes;
+    }
+
+    void Texture::Upload(
+        int aDroppedLevels)
+    {
+        std::string_view encoded;
+        try
+        {
+            encoded = mVfs.Read(mPath);
+        }
+        catch (const VfsException &e)
+        {
+            std::string errorMsg = "Exception while reading texture: ";
+            errorMsg += e.what();
+            throw TextureException(errorMsg);
+        }
+
+        stbi_uc *data = stbi_load_from_memory(
+            reinterpret_cast<const stbi_uc *>(encoded.data()),
+            static_cast<int>(encoded.size()), &mWidth, &mHeight, &mChannels,
+            0);
+        if (!data)
+        {
+            throw TextureException("Could not decode texture " + mPath +
+                                   ": " + stbi_failure_reason());
+        }
+
+        // Box filter the decoded image down on the CPU, so dropping levels
+        // never has to read anything back from the GPU
+        aDroppedLevels = std::min(aDroppedLevels, LevelCount() - 1);
+        int width = mWidth;
+        int height = mHeight;
+        const std::size_t size = static_cast<std::size_t>(width) *
+                                 static_cast<std::size_t>(height) *
+                                 static_cast<std::size_t>(mChannels);
+        std::vector<unsigned char> image(data, data + size);
+        stbi_image_free(data);
+        for (int level = 0; level < aDroppedLevels; ++level)
+        {
+            image = HalveImage(image, width, height);
+            width = std::max(1, width >> 1);
+            height = std::max(1, height >> 1);
+        }
+
+        const GLenum format = Format();
+        // Sized formats fix the storage, so Bytes matches what the driver
+        // allocates. RGB is stored as RGBA by most drivers anyway.
+        const GLenum internalFormat = 1 == mChannels   ? GL_R8
+                                      : 2 == mChannels ? GL_RG8
+                                                       : GL_RGBA8;
+        // stb_image returns tightly packed rows
+        GLint unpackAlignment;
+        glGetIntegerv(GL_UNPACK_ALIGNMENT, &unpackAlignment);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glTexImage2D(/* target         = */ GL_TEXTURE_2D,
+                     /* level          = */ 0,
+                     /* internalFormat = */ internalFormat,
+                     /* width          = */ width,
+                     /* height         = */ height,
+                     /* border         = */ 0,
+                     /* format         = */ format,
+                     /* type           = */ GL_UNSIGNED_BYTE,
+                     /* data           = */ image.data());
+        glPixelStorei(GL_UNPACK_ALIGNMENT, unpackAlignment);
+        if (mChannels < 3)
+        {
+            // Sample grey and grey+alpha images as grey rather than red or
+            // red/green, like the glyph atlas of Font
+            const GLint swizzle[] = {GL_RED, GL_RED, GL_RED,
+                                     1 == mChannels ? GL_ONE : GL_GREEN};
+            glTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_RGBA, swizzle);
+        }
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL,
+                        LevelCount() - 1 - aDroppedLevels);
+        glGenerateMipmap(GL_TEXTURE_2D);
+        mDroppedLevels = aDroppedLevels;
+    }
+
+    std::size_t Texture::DropLevels(
+        std::size_t aBytesToFree)
+    {
+        const int lastLevel = LevelCount() - 1;
+        if (mDroppedLevels >= lastLevel)
+        {
+            return Bytes();
+        }
+
+        // Pick the number of levels up front, so the image is decoded and
+        // uploaded only once however far it has to shrink
+        const std::size_t bytes = Bytes();
+        int droppedLevels = mDroppedLevels + 1;
+        while (droppedLevels < lastLevel &&
+               bytes - LevelBytes(droppedLevels) < aBytesToFree)
+        {
+            ++droppedLevels;
+        }
+
+        GLint boundTexture;
+        glGetIntegerv(GL_TEXTURE_BINDING_2D, &boundTexture);
+        glBindTexture(GL_TEXTURE_2D, mTextureId);
+        try
+        {
+            // Respecifying level 0 at the smaller size makes the driver
+            // release the storage of the dropped level while keeping the ID
+            Upload(droppedLevels);
+        }
+        catch (const TextureException &)
+        {
+            // The pack was readable at construction, so this only happens
+            // when decoding runs out of memory. Keep the current levels.
+        }
+        glBindTexture(GL_TEXTURE_2D, boundTexture);
+        return Bytes();
+    }
+
+    std::vector<unsigned char> Texture::HalveImage(
+        const std::vector<unsigned char> &aImage,
+        int aWidth,
+        int aHeight) const
+    {
+        const int width = std::max(1, aWidth >> 1);
+        const int height = std::max(1, aHeight >> 1);
+        std::vector<unsigned char> halved(static_cast<std::size_t>(width) *
+                                          static_cast<std::size_t>(height) *
+                                          static_cast<std::size_t>(mChannels));
+
+        // Average 2x2 blocks. Sides of length one repeat their only texel,
+        // an odd last row or column is dropped like the GL mip sizes do.
+        const std::size_t channels = static_cast<std::size_t>(mChannels);
+        auto offset = [channels](int aX, int aY, int aRowLength)
+        {
+            return (static_cast<std::size_t>(aY) * aRowLength + aX) *
+                   channels;
+        };
+        for (int y = 0; y < height; ++y)
+        {
+            const int y0 = std::min(2 * y, aHeight - 1);
+            const int y1 = std::min(2 * y + 1, aHeight - 1);
+            for (int x = 0; x < width; ++x)
+            {
+                const int x0 = std::min(2 * x, aWidth - 1);
+                const int x1 = std::min(2 * x + 1, aWidth - 1);
+                const unsigned char *topLeft = &aImage[offset(x0, y0, aWidth)];
+                const unsigned char *topRight = &aImage[offset(x1, y0, aWidth)];
+                const unsigned char *bottomLeft =
+                    &aImage[offset(x0, y1, aWidth)];
+                const unsigned char *bottomRight =
+                    &aImage[offset(x1, y1, aWidth)];
+                unsigned char *target = &halved[offset(x, y, width)];
+                for (std::size_t c = 0; c < channels; ++c)
+                {
+                    target[c] = static_cast<unsigned char>(
+                        (topLeft[c] + topRight[c] + bottomLeft[c] +
+                         bottomRight[c] + 2) /
+                        4);
+                }
+            }
+        }
+        return halved;
+    }
+
+    GLenum Texture::Format() const noexcept
+    {
+        switch (mChannels)
+        {
+        case 1:
+            return GL_RED;
+        case 2:
+            return GL_RG;
+        case 3:
+            return GL_RGB;
+        default:
+            return GL_RGBA;
+        }
+    }
+
+    TextureException::TextureException(
+        std::string aErrorMsg) noexcept
+        : mErrorMsg(aErrorMsg)
+    {
+    }
+
+    const char *TextureException::what() const noexcept
+    {
+        return mErrorMsg.c_str();
+    }
+
+} // namespace Glance
@@ -0,0 +1,331 @@
+/**
+ * Copyright 2021 Christoph Groß
+ *
+ * This file is part of Glance.
+ *
+ * Glance is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Glance is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Glance.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "vfs.hpp"
+
+namespace Glance
+{
+
+    std::uint64_t PackHash(
+        std::string_view aPath) noexcept
+    {
+        std::uint64_t hash = 0xcbf29ce484222325ull;
+        for (char c : aPath)
+        {
+            hash ^= static_cast<unsigned char>(c);
+            hash *= 0x100000001b3ull;
+        }
+        return hash;
+    }
+
+    void PackWriter::Add(
+        const std::string &aPath,
+        std::string aData)
+    {
+        mFiles[aPath] = std::move(aData);
+    }
+
+    void PackWriter::AddFile(
+        const std::string &aPath,
+        const std::string &aSourcePath)
+    {
+        std::ifstream sourceFile;
+        sourceFile.exceptions(std::ifstream::failbit |
+                              std::ifstream::badbit);
+
+        try
+        {
+            std::stringstream sourceStream;
+
+            sourceFile.open(aSourcePath, std::ios::binary);
+            sourceStream << sourceFile.rdbuf();
+            sourceFile.close();
+            Add(aPath, sourceStream.str());
+        }
+        catch (const std::ifstream::failure &e)
+        {
+            std::string errorMsg = "Exception while reading " + aSourcePath +
+                                   ": ";
+            errorMsg += e.what();
+            throw VfsException(errorMsg);
+        }
+    }
+
+    void PackWriter::Write(
+        const std::string &aPackPath) const
+    {
+        std::vector<PackEntry> entries;
+        std::vector<const std::string *> data;
+        std::string names;
+
+        entries.reserve(mFiles.size());
+        data.reserve(mFiles.size());
+        for (const auto &file : mFiles)
+        {
+            PackEntry entry = {};
+            entry.mHash = PackHash(file.first);
+            entry.mDataSize = file.second.size();
+            entry.mNameOffset = static_cast<std::uint32_t>(names.size());
+            entry.mNameLength = static_cast<std::uint32_t>(file.first.size());
+            names += file.first;
+            entries.push_back(entry);
+            data.push_back(&file.second);
+        }
+
+        // Lay out the data blobs behind the index and the name blob
+        std::uint64_t namesOffset = sizeof(PackHeader) +
+                                    entries.size() * sizeof(PackEntry);
+        std::uint64_t offset = namesOffset + names.size();
+        for (std::size_t i = 0; i < entries.size(); ++i)
+        {
+            offset = (offset + PackDataAlignment - 1) &
+                     ~(PackDataAlignment - 1);
+            entries[i].mDataOffset = offset;
+            offset += entries[i].mDataSize;
+        }
+
+        // The index is sorted by hash. Entries are already ordered by name,
+        // so ties keep that order and the output stays deterministic.
+        std::vector<std::size_t> order(entries.size());
+        for (std::size_t i = 0; i < order.size(); ++i)
+        {
+            order[i] = i;
+        }
+        std::sort(order.begin(), order.end(),
+                  [&entries](std::size_t aLeft, std::size_t aRight)
+                  {
+                      return entries[aLeft].mHash < entries[aRight].mHash ||
+                             (entries[aLeft].mHash == entries[aRight].mHash &&
+                              aLeft < aRight);
+                  });
+
+        PackHeader header = {};
+        std::memcpy(header.mMagic, PackMagic, sizeof(header.mMagic));
+        header.mVersion = PackVersion;
+        header.mEntryCount = static_cast<std::uint32_t>(entries.size());
+        header.mNamesOffset = namesOffset;
+        header.mDataOffset = entries.empty() ? namesOffset + names.size()
+                                             : entries.front().mDataOffset;
+
+        std::ofstream packFile(aPackPath, std::ios::binary | std::ios::trunc);
+        if (!packFile)
+        {
+            throw VfsException("Could not open " + aPackPath +
+                               " for writing");
+        }
+
+        packFile.write(reinterpret_cast<const char *>(&header),
+                       sizeof(header));
+        for (std::size_t i : order)
+        {
+            packFile.write(reinterpret_cast<const char *>(&entries[i]),
+                           sizeof(PackEntry));
+        }
+        packFile.write(names.data(), names.size());
+        std::uint64_t position = namesOffset + names.size();
+        for (std::size_t i = 0; i < entries.size(); ++i)
+        {
+            static const char padding[PackDataAlignment] = {};
+            packFile.write(padding, entries[i].mDataOffset - position);
+            packFile.write(data[i]->data(), data[i]->size());
+            position = entries[i].mDataOffset + entries[i].mDataSize;
+        }
+
+        if (!packFile)
+        {
+            throw VfsException("Failed to write " + aPackPath);
+        }
+    }
+
+    Vfs::Vfs(
+        const std::string &aPackPath)
+        : mData(nullptr),
+          mSize(0),
+          mEntries(nullptr),
+          mEntryCount(0)
+    {
+        int fd = open(aPackPath.c_str(), O_RDONLY | O_CLOEXEC);
+        if (-1 == fd)
+        {
+            throw VfsException("Could not open " + aPackPath + ": " +
+                               std::strerror(errno));
+        }
+
+        struct stat status;
+        if (-1 == fstat(fd, &status))
+        {
+            std::string errorMsg = "Could not stat " + aPackPath + ": " +
+                                   std::strerror(errno);
+            close(fd);
+            throw VfsException(errorMsg);
+        }
+        if (static_cast<std::size_t>(status.st_size) < sizeof(PackHeader))
+        {
+            close(fd);
+            throw VfsException(aPackPath + " is not an asset pack");
+        }
+
+        mSize = static_cast<std::size_t>(status.st_size);
+        void *mapping = mmap(nullptr, mSize, PROT_READ, MAP_PRIVATE, fd, 0);
+        int mapError = errno;
+        // The mapping keeps its own reference to the file
+        close(fd);
+        if (MAP_FAILED == mapping)
+        {
+            throw VfsException("Could not map " + aPackPath + ": " +
+                               std::strerror(mapError));
+        }
+        mData = static_cast<const char *>(mapping);
+
+        const PackHeader *header = reinterpret_cast<const PackHeader *>(mData);
+        const std::uint64_t indexEnd = sizeof(PackHeader) +
+                                       static_cast<std::uint64_t>(
+                                           header->mEntryCount) *
+                                           sizeof(PackEntry);
+        bool valid = 0 == std::memcmp(header->mMagic, PackMagic,
+                                      sizeof(PackMagic)) &&
+                     PackVersion == header->mVersion &&
+                     indexEnd <= mSize &&
+                     header->mNamesOffset <= mSize;
+
+        mEntries = reinterpret_cast<const PackEntry *>(mData +
+                                                       sizeof(PackHeader));
+        mEntryCount = valid ? header->mEntryCount : 0;
+
+        // Validate the index once here, so lookups can trust it later on
+        for (std::uint32_t i = 0; valid && i < mEntryCount; ++i)
+        {
+            const PackEntry &entry = mEntries[i];
+            const std::uint64_t nameOffset = header->mNamesOffset +
+                                             entry.mNameOffset;
+            valid = nameOffset + entry.mNameLength <= mSize &&
+                    entry.mDataOffset <= mSize &&
+                    entry.mDataSize <= mSize - entry.mDataOffset &&
+                    (0 == i || mEntries[i - 1].mHash <= entry.mHash);
+        }
+        if (!valid)
+        {
+            munmap(const_cast<char *>(mData), mSize);
+            throw VfsException(aPackPath + " is not a valid asset pack");
+        }
+    }
+
+    Vfs::~Vfs()
+    {
+        munmap(const_cast<char *>(mData), mSize);
+    }
+
+    const PackEntry *Vfs::Find(
+        std::string_view aPath) const noexcept
+    {
+        const std::uint64_t hash = PackHash(aPath);
+        const PackEntry *end = mEntries + mEntryCount;
+        const PackEntry *entry = std::lower_bound(
+            mEntries, end, hash,
+            [](const PackEntry &aEntry, std::uint64_t aHash)
+            {
+                return aEntry.mHash < aHash;
+            });
+
+        const char *names = mData +
+                            reinterpret_cast<const PackHeader *>(mData)
+                                ->mNamesOffset;
+        for (; entry != end && entry->mHash == hash; ++entry)
+        {
+            if (aPath == std::string_view(names + entry->mNameOffset,
+                                          entry->mNameLength))
+            {
+                return entry;
+            }
+        }
+        return nullptr;
+    }
+
+    bool Vfs::Contains(
+        std::string_view aPath) const noexcept
+    {
+        return nullptr != Find(aPath);
+    }
+
+    std::string_view Vfs::Read(
+        std::string_view aPath) const
+    {
+        const PackEntry *entry = Find(aPath);
+        if (!entry)
+        {
+            throw VfsException("No such file in asset pack: " +
+                               std::string(aPath));
+        }
+        return std::string_view(mData + entry->mDataOffset,
+                                entry->mDataSize);
+    }
+
+    std::size_t Vfs::FileCount() const noexcept
+    {
+        return mEntryCount;
+    }
+
+    std::string Vfs::ExecutableDirectory()
+    {
+        std::vector<char> path(256);
+        for (;;)
+        {
+            ssize_t length = readlink("/proc/self/exe", path.data(),
+                                      path.size());
+            if (-1 == length)
+            {
+                throw VfsException(
+                    std::string("Could not determine executable path: ") +
+                    std::strerror(errno));
+            }
+            if (static_cast<std::size_t>(length) < path.size())
+            {
+                std::string directory(path.data(), length);
+                return directory.substr(0, directory.rfind('/') + 1);
+            }
+            // readlink truncates silently, so retry with a larger buffer
+            path.resize(path.size() * 2);
+        }
+    }
+
+    VfsException::VfsException(
+        std::string aErrorMsg) noexcept
+        : mErrorMsg(aErrorMsg)
+    {
+    }
+
+    const char *VfsException::what() const noexcept
+    {
+        return mErrorMsg.c_str();
+    }
+
+} // namespace Glance
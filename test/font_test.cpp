@@ -0,0 +1,105 @@
+/**
+ * Copyright 2021 Christoph Groß
+ *
+ * This file is part of Glance.
+ *
+ * Glance is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Glance is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Glance.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include <cstddef>
+#include <cstdio>
+#include <string>
+
+#include <unistd.h>
+
+#include <gtest/gtest.h>
+
+#include "font.hpp"
+
+namespace Glance
+{
+
+class FontTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        mPackPath = "font_test_" + std::to_string( getpid() ) + ".pack";
+
+        PackWriter writer;
+        writer.Add( "font/garbage.ttf", std::string( 64, 'x' ) );
+        writer.Add( "font/truncated.ttf", "\1" );
+        writer.AddFile( "font/SourceCodePro-Regular.ttf",
+                        GLANCE_EXAMPLE_FONT );
+        writer.Write( mPackPath );
+    }
+
+    void TearDown() override
+    {
+        std::remove( mPackPath.c_str() );
+    }
+
+    // Location of the asset pack used by the tests
+    std::string mPackPath;
+};
+
+TEST_F( FontTest, ThrowsFontExceptionOnInvalidPath )
+{
+    Vfs vfs( mPackPath );
+    EXPECT_THROW( Font( vfs, "invalid/font/path", 16.f ), FontException );
+}
+
+TEST_F( FontTest, ThrowsFontExceptionOnInvalidFont )
+{
+    Vfs vfs( mPackPath );
+    EXPECT_THROW( Font( vfs, "font/garbage.ttf", 16.f ), FontException );
+    EXPECT_THROW( Font( vfs, "font/truncated.ttf", 16.f ), FontException );
+}
+
+TEST_F( FontTest, ThrowsFontExceptionOnInvalidAtlasData )
+{
+    EXPECT_THROW( FontAtlas( "", "empty", 16.f ), FontException );
+}
+
+TEST_F( FontTest, MeasuresTextWithRealFont )
+{
+    Vfs vfs( mPackPath );
+    FontAtlas atlas( vfs.Read( "font/SourceCodePro-Regular.ttf" ),
+                     "font/SourceCodePro-Regular.ttf", 16.f );
+
+    // Source Code Pro has ascent 984, descent -273 and no line gap, every
+    // printable ASCII glyph advances by 600 of 1000 units
+    const float advance = 600.f * 16.f / 1257.f;
+    EXPECT_NEAR( 16.f, atlas.LineHeight(), 1e-3f );
+    EXPECT_NEAR( 3.f * advance, atlas.Measure( "abc" ), 1e-3f );
+    EXPECT_FLOAT_EQ( atlas.Measure( "iii" ), atlas.Measure( "WWW" ) );
+    EXPECT_FLOAT_EQ( atlas.Measure( "abcd" ),
+                     atlas.Measure( "ab\nabcd\nabc" ) );
+    EXPECT_FLOAT_EQ( 0.f, atlas.Measure( "" ) );
+    EXPECT_FLOAT_EQ( 0.f, atlas.Measure( "\t\n" ) );
+
+    ASSERT_NE( nullptr, atlas.Find( 'A' ) );
+    EXPECT_EQ( nullptr, atlas.Find( '\n' ) );
+    EXPECT_EQ( static_cast<std::size_t>( atlas.Width() ) * atlas.Height(),
+               atlas.Bitmap().size() );
+}
+
+}   // namespace Glance
+
+int main( int argc, char** argv )
+{
+    ::testing::InitGoogleTest( &argc, argv );
+    return RUN_ALL_TESTS();
+}
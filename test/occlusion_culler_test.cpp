@@ -0,0 +1,95 @@
+/**
+ * Copyright 2021 Christoph Groß
+ *
+ * This file is part of Glance.
+ *
+ * Glance is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Glance is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Glance.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+
+#include "occlusion_culler.hpp"
+
+namespace Glance
+{
+
+// Pyramid of an 800x600 viewport, level 9 is 1x1
+constexpr int Width = 800;
+constexpr int Height = 600;
+constexpr int Levels = 10;
+
+TEST( OcclusionCullerTest, CoversAllTexelsOfRoundedDownLevels )
+{
+    // Rows 505 to 533 fall into texels 15 and 16 of the 18 rows of level 5.
+    // Scaling the coordinates by the level size instead only finds 15.
+    detail::HiZTexelRange range = detail::SelectHiZTexels(
+        100.f / Width, 505.f / Height,
+        110.f / Width, 533.5f / Height,
+        Width, Height, Levels );
+
+    ASSERT_EQ( 5, range.mLevel );
+    EXPECT_EQ( 18, detail::HiZLevelSize( Height, range.mLevel ) );
+    EXPECT_EQ( 15, range.mMinY );
+    EXPECT_EQ( 16, range.mMaxY );
+    EXPECT_EQ( 3, range.mMinX );
+    EXPECT_EQ( 3, range.mMaxX );
+}
+
+TEST( OcclusionCullerTest, ClampsToFoldedLastTexel )
+{
+    // Level 4 has 37 rows, the odd rows 592 to 599 of level 3 are folded
+    // into its last row
+    detail::HiZTexelRange range = detail::SelectHiZTexels(
+        0.f, 590.f / Height,
+        1.f / Width, 1.f,
+        Width, Height, Levels );
+
+    ASSERT_EQ( 4, range.mLevel );
+    EXPECT_EQ( 36, range.mMinY );
+    EXPECT_EQ( 36, range.mMaxY );
+}
+
+TEST( OcclusionCullerTest, UsesBaseLevelForSingleTexels )
+{
+    detail::HiZTexelRange range = detail::SelectHiZTexels(
+        .5f, .5f, .5f, .5f,
+        Width, Height, Levels );
+
+    EXPECT_EQ( 0, range.mLevel );
+    EXPECT_EQ( 400, range.mMinX );
+    EXPECT_EQ( 400, range.mMaxX );
+    EXPECT_EQ( 300, range.mMinY );
+    EXPECT_EQ( 300, range.mMaxY );
+}
+
+TEST( OcclusionCullerTest, StopsAtTheLastLevel )
+{
+    detail::HiZTexelRange range = detail::SelectHiZTexels(
+        0.f, 0.f, 1.f, 1.f,
+        Width, Height, Levels );
+
+    EXPECT_EQ( Levels - 1, range.mLevel );
+    EXPECT_EQ( 0, range.mMinX );
+    EXPECT_EQ( 0, range.mMaxX );
+    EXPECT_EQ( 0, range.mMinY );
+    EXPECT_EQ( 0, range.mMaxY );
+}
+
+}   // namespace Glance
+
+int main( int argc, char** argv )
+{
+    ::testing::InitGoogleTest( &argc, argv );
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,299 @@
+/**
+ * Copyright 2021 Christoph Groß
+ *
+ * This file is part of Glance.
+ *
+ * Glance is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Glance is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Glance.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include <cstddef>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "resource_registry.hpp"
+
+namespace Glance
+{
+
+class ResourceRegistryTest : public ::testing::Test
+{
+protected:
+    /**
+     * @brief   Eviction callback halving a resource down to a minimum size
+     * @details Halves until the requested bytes are freed, like a texture
+     *          dropping several mip levels at once.
+     */
+    ResourceRegistry::EvictCallback Halve( std::size_t &aBytes,
+                                           std::size_t aMinimum = 1 )
+    {
+        return [&aBytes, aMinimum]( std::size_t aBytesToFree )
+        {
+            const std::size_t initial = aBytes;
+            while ( aBytes > aMinimum && initial - aBytes < aBytesToFree )
+            {
+                aBytes /= 2;
+            }
+            return aBytes;
+        };
+    }
+};
+
+TEST_F( ResourceRegistryTest, TracksResidentBytesPerType )
+{
+    ResourceRegistry registry( 1000 );
+    ResourceId texture = registry.Register( ResourceType::Texture, 300,
+                                            "texture" );
+    ResourceId buffer = registry.Register( ResourceType::Buffer, 200,
+                                           "buffer" );
+    registry.EndFrame();
+
+    EXPECT_EQ( 500u, registry.Stats().mResidentBytes );
+    EXPECT_EQ( 300u, registry.Stats().mTextureBytes );
+    EXPECT_EQ( 200u, registry.Stats().mBufferBytes );
+    EXPECT_EQ( 2u, registry.Stats().mResourceCount );
+    EXPECT_EQ( "texture", registry.Owner( texture ) );
+
+    registry.Resize( buffer, 100 );
+    registry.Unregister( texture );
+    registry.EndFrame();
+
+    EXPECT_EQ( 100u, registry.Stats().mResidentBytes );
+    EXPECT_EQ( 1u, registry.Stats().mResourceCount );
+    EXPECT_EQ( 0u, registry.Bytes( texture ) );
+}
+
+TEST_F( ResourceRegistryTest, EvictsLeastRecentlyUsedFirst )
+{
+    ResourceRegistry registry( 1000 );
+    std::size_t oldBytes = 400;
+    std::size_t newBytes = 400;
+    ResourceId oldId = registry.Register( ResourceType::Texture, oldBytes,
+                                          "old", Halve( oldBytes ) );
+    ResourceId newId = registry.Register( ResourceType::Texture, newBytes,
+                                          "new", Halve( newBytes ) );
+    registry.EndFrame();
+
+    registry.Touch( newId );
+    registry.EndFrame();
+
+    registry.Register( ResourceType::Buffer, 400, "pinned" );
+    registry.EndFrame();
+
+    EXPECT_EQ( 200u, registry.Bytes( oldId ) );
+    EXPECT_EQ( 400u, registry.Bytes( newId ) );
+    EXPECT_EQ( 1000u, registry.Stats().mResidentBytes );
+    EXPECT_EQ( 1u, registry.Stats().mEvictions );
+    EXPECT_EQ( 1u, registry.Stats().mReducedCount );
+}
+
+TEST_F( ResourceRegistryTest, NeverEvictsResourcesUsedThisFrame )
+{
+    ResourceRegistry registry( 100 );
+    std::size_t bytes = 400;
+    ResourceId id = registry.Register( ResourceType::Texture, bytes,
+                                       "texture", Halve( bytes ) );
+    registry.Touch( id );
+    registry.EndFrame();
+
+    EXPECT_EQ( 400u, registry.Bytes( id ) );
+    EXPECT_EQ( 0u, registry.Stats().mEvictions );
+
+    registry.EndFrame();
+
+    EXPECT_EQ( 100u, registry.Bytes( id ) );
+}
+
+TEST_F( ResourceRegistryTest, StopsWhenNothingIsEvictable )
+{
+    ResourceRegistry registry( 100 );
+    std::size_t bytes = 400;
+    ResourceId id = registry.Register( ResourceType::Texture, bytes,
+                                       "texture", Halve( bytes, 200 ) );
+    registry.Register( ResourceType::Buffer, 400, "buffer" );
+    registry.EndFrame();
+    registry.EndFrame();
+
+    EXPECT_EQ( 200u, registry.Bytes( id ) );
+    EXPECT_EQ( 600u, registry.Stats().mResidentBytes );
+}
+
+TEST_F( ResourceRegistryTest, RestoresUsedResourcesOnceWithinBudget )
+{
+    ResourceRegistry registry( 500 );
+    std::size_t bytes = 400;
+    ResourceId id = registry.Register(
+        ResourceType::Texture, bytes, "texture", Halve( bytes ),
+        [&bytes]()
+        {
+            bytes = 400;
+            return bytes;
+        } );
+    ResourceId buffer = registry.Register( ResourceType::Buffer, 200,
+                                           "buffer" );
+    registry.EndFrame();
+    registry.EndFrame();
+    ASSERT_EQ( 200u, registry.Bytes( id ) );
+
+    // Not restored while unused, even with room in the budget
+    registry.Unregister( buffer );
+    registry.EndFrame();
+    EXPECT_EQ( 200u, registry.Bytes( id ) );
+
+    registry.Touch( id );
+    registry.EndFrame();
+    EXPECT_EQ( 400u, registry.Bytes( id ) );
+    EXPECT_EQ( 1u, registry.Stats().mRestores );
+    EXPECT_EQ( 0u, registry.Stats().mReducedCount );
+}
+
+TEST_F( ResourceRegistryTest, ShrinksEachResourceInOneStep )
+{
+    ResourceRegistry registry( 100 );
+    std::size_t bytes = 800;
+    std::size_t calls = 0;
+    ResourceId id = registry.Register(
+        ResourceType::Texture, bytes, "texture",
+        [&bytes, &calls]( std::size_t aBytesToFree )
+        {
+            ++calls;
+            EXPECT_EQ( 700u, aBytesToFree );
+            bytes = 100;
+            return bytes;
+        } );
+    registry.EndFrame();
+    registry.EndFrame();
+
+    EXPECT_EQ( 100u, registry.Bytes( id ) );
+    EXPECT_EQ( 1u, calls );
+    EXPECT_EQ( 1u, registry.Stats().mEvictions );
+}
+
+TEST_F( ResourceRegistryTest, CarriesEvictionsOverToLaterFrames )
+{
+    ResourceRegistry registry( 300 );
+    registry.SetMaxEvictionsPerFrame( 1 );
+    std::size_t bytes[3] = { 200, 200, 200 };
+    ResourceId ids[3];
+    for ( int i = 0; i < 3; ++i )
+    {
+        ids[i] = registry.Register( ResourceType::Texture, bytes[i],
+                                    "texture", Halve( bytes[i], 50 ) );
+    }
+    registry.EndFrame();
+
+    // Over by 300, but only one texture may be shrunk per frame
+    registry.EndFrame();
+    EXPECT_EQ( 50u, registry.Bytes( ids[0] ) );
+    EXPECT_EQ( 200u, registry.Bytes( ids[1] ) );
+    EXPECT_EQ( 450u, registry.Stats().mResidentBytes );
+    EXPECT_EQ( 1u, registry.Stats().mEvictions );
+
+    registry.EndFrame();
+    EXPECT_EQ( 50u, registry.Bytes( ids[1] ) );
+    EXPECT_EQ( 300u, registry.Stats().mResidentBytes );
+
+    registry.EndFrame();
+    EXPECT_EQ( 200u, registry.Bytes( ids[2] ) );
+    EXPECT_EQ( 0u, registry.Stats().mEvictions );
+}
+
+TEST_F( ResourceRegistryTest, EvictsWhenDeviceRunsLowOnMemory )
+{
+    ResourceRegistry registry( 1000 );
+    std::size_t bytes = 400;
+    ResourceId id = registry.Register( ResourceType::Texture, bytes,
+                                       "texture", Halve( bytes ) );
+    std::size_t freeBytes = 300;
+    registry.SetMinimumFree( 100 );
+    registry.SetFreeMemorySource( [&freeBytes]()
+                                  {
+                                      return freeBytes;
+                                  } );
+    registry.EndFrame();
+    registry.EndFrame();
+
+    // Enough free memory, the device only caps the budget
+    EXPECT_EQ( 400u, registry.Bytes( id ) );
+    EXPECT_EQ( 600u, registry.Stats().mBudgetBytes );
+
+    // Someone else allocated, free memory is 50 short of the minimum
+    freeBytes = 50;
+    registry.EndFrame();
+
+    EXPECT_EQ( 350u, registry.Stats().mBudgetBytes );
+    EXPECT_EQ( 200u, registry.Bytes( id ) );
+    EXPECT_EQ( 1u, registry.Stats().mEvictions );
+}
+
+TEST_F( ResourceRegistryTest, FollowsDeviceMemoryBeyondFallbackBudget )
+{
+    ResourceRegistry registry( 100 );
+    std::size_t bytes = 400;
+    ResourceId id = registry.Register( ResourceType::Texture, bytes,
+                                       "texture", Halve( bytes ) );
+    registry.SetMinimumFree( 0 );
+    registry.SetFreeMemorySource( []()
+                                  {
+                                      return std::size_t( 1000 );
+                                  } );
+    registry.EndFrame();
+    registry.EndFrame();
+
+    // The fallback budget is no limit once the device reports its memory
+    EXPECT_EQ( 1400u, registry.Stats().mBudgetBytes );
+    EXPECT_EQ( 400u, registry.Bytes( id ) );
+
+    // An explicit limit is
+    registry.SetBudget( 200 );
+    registry.EndFrame();
+    EXPECT_EQ( 200u, registry.Stats().mBudgetBytes );
+    EXPECT_EQ( 200u, registry.Bytes( id ) );
+
+    registry.SetBudget( std::nullopt );
+    registry.EndFrame();
+    EXPECT_EQ( 1200u, registry.Stats().mBudgetBytes );
+}
+
+TEST_F( ResourceRegistryTest, RejectsReleasedHandles )
+{
+    ResourceRegistry registry( 1000 );
+    ResourceId first = registry.Register( ResourceType::Buffer, 1, "first" );
+    registry.Unregister( first );
+    ResourceId second = registry.Register( ResourceType::Buffer, 2,
+                                           "second" );
+
+    // The slot is reused, the stale handle must not reach the new resource
+    EXPECT_NE( first, second );
+    EXPECT_EQ( 0u, registry.Bytes( first ) );
+    EXPECT_EQ( "", registry.Owner( first ) );
+
+    registry.Resize( first, 5 );
+    registry.Unregister( first );
+    registry.EndFrame();
+
+    EXPECT_EQ( 2u, registry.Bytes( second ) );
+    EXPECT_EQ( "second", registry.Owner( second ) );
+    EXPECT_EQ( 2u, registry.Stats().mResidentBytes );
+    EXPECT_EQ( 1u, registry.Stats().mResourceCount );
+}
+
+}   // namespace Glance
+
+int main( int argc, char** argv )
+{
+    ::testing::InitGoogleTest( &argc, argv );
+    return RUN_ALL_TESTS();
+}
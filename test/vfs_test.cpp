@@ -0,0 +1,119 @@
+/**
+ * Copyright 2021 Christoph Groß
+ *
+ * This file is part of Glance.
+ *
+ * Glance is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Glance is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Glance.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include <cstdio>
+#include <string>
+
+#include <unistd.h>
+
+#include <gtest/gtest.h>
+
+#include "vfs.hpp"
+
+namespace Glance
+{
+
+class VfsTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        mPackPath = "vfs_test_" + std::to_string( getpid() ) + ".pack";
+    }
+
+    void TearDown() override
+    {
+        std::remove( mPackPath.c_str() );
+    }
+
+    // Location of the asset pack written by a test
+    std::string mPackPath;
+};
+
+TEST_F( VfsTest, ReadsFilesWrittenByPackWriter )
+{
+    PackWriter writer;
+    writer.Add( "shader/a.vs", "vertex" );
+    writer.Add( "shader/a.fs", "fragment" );
+    writer.Add( "texture/empty", "" );
+    writer.Add( "binary", std::string( "\0\1\2", 3 ) );
+    writer.Write( mPackPath );
+
+    Vfs vfs( mPackPath );
+    EXPECT_EQ( 4u, vfs.FileCount() );
+    EXPECT_EQ( "vertex", vfs.Read( "shader/a.vs" ) );
+    EXPECT_EQ( "fragment", vfs.Read( "shader/a.fs" ) );
+    EXPECT_EQ( "", vfs.Read( "texture/empty" ) );
+    EXPECT_EQ( std::string( "\0\1\2", 3 ), vfs.Read( "binary" ) );
+}
+
+TEST_F( VfsTest, AlignsFileContents )
+{
+    PackWriter writer;
+    writer.Add( "a", "1" );
+    writer.Add( "b", "22" );
+    writer.Add( "c", "333" );
+    writer.Write( mPackPath );
+
+    Vfs vfs( mPackPath );
+    const char *base = vfs.Read( "a" ).data();
+    for ( const char *path : { "a", "b", "c" } )
+    {
+        EXPECT_EQ( 0u, ( vfs.Read( path ).data() - base ) %
+                       PackDataAlignment );
+    }
+}
+
+TEST_F( VfsTest, ContainsOnlyAddedFiles )
+{
+    PackWriter writer;
+    writer.Add( "shader/a.vs", "vertex" );
+    writer.Write( mPackPath );
+
+    Vfs vfs( mPackPath );
+    EXPECT_TRUE( vfs.Contains( "shader/a.vs" ) );
+    EXPECT_FALSE( vfs.Contains( "shader/a.fs" ) );
+    EXPECT_FALSE( vfs.Contains( "a.vs" ) );
+    EXPECT_THROW( vfs.Read( "shader/a.fs" ), VfsException );
+}
+
+TEST_F( VfsTest, ThrowsVfsExceptionOnInvalidPath )
+{
+    EXPECT_THROW( Vfs( "invalid/pack/path" ), VfsException );
+}
+
+TEST_F( VfsTest, ThrowsVfsExceptionOnMalformedPack )
+{
+    FILE *file = std::fopen( mPackPath.c_str(), "wb" );
+    ASSERT_NE( nullptr, file );
+    const std::string garbage( sizeof( PackHeader ) * 2, 'x' );
+    std::fwrite( garbage.data(), 1, garbage.size(), file );
+    std::fclose( file );
+
+    EXPECT_THROW( Vfs vfs( mPackPath ), VfsException );
+}
+
+}   // namespace Glance
+
+int main( int argc, char** argv )
+{
+    ::testing::InitGoogleTest( &argc, argv );
+    return RUN_ALL_TESTS();
+}
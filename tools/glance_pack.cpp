@@ -0,0 +1,70 @@
+/**
+ * Copyright 2021 Christoph Groß
+ *
+ * This file is part of Glance.
+ *
+ * Glance is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Glance is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Glance.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include <iostream>
+#include <string>
+
+#include "vfs.hpp"
+
+/**
+ * @brief   Bundle asset files into a single asset pack
+ * @details Usage: glance_pack <output> <root> <file>...
+ *          Every file is stored under its path relative to root, using
+ *          forward slashes, so it can be looked up with Glance::Vfs::Read.
+ */
+int main(int argc, char **argv)
+{
+    if (argc < 3)
+    {
+        std::cerr << "Usage: " << argv[0] << " <output> <root> <file>..."
+                  << std::endl;
+        return 1;
+    }
+
+    std::string root = argv[2];
+    if (!root.empty() && '/' != root.back())
+    {
+        root += '/';
+    }
+
+    try
+    {
+        Glance::PackWriter writer;
+        for (int i = 3; i < argc; ++i)
+        {
+            std::string sourcePath = argv[i];
+            if (0 != sourcePath.compare(0, root.size(), root))
+            {
+                std::cerr << "ERROR: " << sourcePath << " is not below "
+                          << root << std::endl;
+                return 1;
+            }
+            writer.AddFile(sourcePath.substr(root.size()), sourcePath);
+        }
+        writer.Write(argv[1]);
+    }
+    catch (const Glance::VfsException &e)
+    {
+        std::cerr << "ERROR: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}